@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/passlang.h"
+#include "../src/validator.h"
+
+
+// Long machine-generated like expression: spaces runs, big numbers, iterators and nested choices
+static std::string makeExpression(size_t size) {
+	const std::vector<std::string> parts = {
+		"n(i0.[1 2 3;40].(i0 * 7 + 3))",
+		"  2-5.-.-",
+		" [1.2.3;30 4.5.6;20 7.-.-]",
+		" 3(2(i1.(i0 * 2048 + i1).1048576))",
+		"    (n - 1)(-)",
+		" 0-9.[100-200;25 300;25 400].65535"
+	};
+
+	std::string expression;
+	for (size_t i = 0; expression.size() < size; i++) {
+		expression += parts[i % parts.size()];
+	}
+	return expression;
+}
+
+// Runs function until at least minSeconds passed, returns MB/s of given input size
+template<typename Function>
+static double measure(size_t size, Function function) {
+	const double minSeconds = 1;
+
+	size_t runs = 0;
+	auto started = std::chrono::steady_clock::now();
+	double seconds = 0;
+	do {
+		function();
+		runs++;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	} while (seconds < minSeconds);
+
+	return double(size) * double(runs) / seconds / 1e6;
+}
+
+int main(int argc, char** args) {
+	size_t size = 64 * 1024;
+	if (argc > 1) {
+		size = size_t(std::strtoull(args[1], nullptr, 10)) * 1024;
+	}
+	std::string expression = makeExpression(size);
+
+	size_t tokens = passlang::tokenize(expression).size();
+	std::cout << "expression: " << expression.size() << " bytes, " << tokens << " tokens" << std::endl;
+
+	std::cout << "tokenize: " << measure(expression.size(), [&expression]() {
+		passlang::Deleter::Pool pool;
+		passlang::Deleter::Scope scope(pool);
+		passlang::tryTokenize(expression);
+	}) << " MB/s" << std::endl;
+
+	std::cout << "validate: " << measure(expression.size(), [&expression]() {
+		passlang::validate(expression);
+	}) << " MB/s" << std::endl;
+
+	std::cout << "compile: " << measure(expression.size(), [&expression]() {
+		passlang::tryCompile(expression);
+	}) << " MB/s" << std::endl;
+
+	return 0;
+}
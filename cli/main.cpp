@@ -0,0 +1,739 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/analyzer.h"
+#include "../src/passlang.h"
+#include "../src/serializer.h"
+
+
+// Reads "checksNumber expression" lines from a file (memory-mapped) or stdin,
+// evaluates them on all cores and writes results in input order
+namespace {
+	const size_t batchLines = 1 << 16;
+	const size_t workChunk = 64;
+
+	enum class Engine {
+		mt19937 = 0,
+		mt19937_64,
+		minstd
+	};
+
+	struct WorldBounds {
+		int world;
+		passlang::Domain::Bounds bounds;
+	};
+
+	struct Options {
+		std::string input = "-";
+		std::string output = "-";
+		passlang::Serializer::Format format = passlang::Serializer::Format::text;
+		uint64_t seed = 0;
+		Engine engine = Engine::mt19937;
+		unsigned threads = 0;
+		int worlds = 10;
+		int coords = 2048;
+		std::vector<int> excluded;
+		std::vector<WorldBounds> worldBounds;
+		bool unique = false;
+		size_t maxRedraws = passlang::Interpreter::defaultMaxRedraws;
+		bool report = false;
+		bool analyze = false;
+		bool checkDomain = false;
+	};
+
+	uint64_t splitmix64(uint64_t value) {
+		value += 0x9e3779b97f4a7c15ULL;
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+		return value ^ (value >> 31);
+	}
+
+	// Every line is reseeded from (seed, line number), so output doesn't depend on thread scheduling
+	class Random {
+	private:
+		Engine engine;
+		std::mt19937 mt;
+		std::mt19937_64 mt64;
+		std::minstd_rand minstd;
+
+	public:
+		Random(Engine engine) : engine(engine) {}
+
+		void seed(uint64_t seed, uint64_t line) {
+			uint64_t value = splitmix64(seed ^ splitmix64(line));
+			if (engine == Engine::mt19937) {
+				mt.seed(uint32_t(value));
+			}
+			else if (engine == Engine::mt19937_64) {
+				mt64.seed(value);
+			}
+			else {
+				minstd.seed(uint32_t(value % (std::minstd_rand::modulus - 1)) + 1);
+			}
+		}
+
+		int range(int start, int finish) {
+			std::uniform_int_distribution<int> distribution(start, finish);
+			if (engine == Engine::mt19937) {
+				return distribution(mt);
+			}
+			else if (engine == Engine::mt19937_64) {
+				return distribution(mt64);
+			}
+			return distribution(minstd);
+		}
+	};
+
+	class InputSource {
+	private:
+		int fd = -1;
+		const char* mapped = nullptr;
+		size_t mappedSize = 0;
+		size_t position = 0;
+
+		std::string buffer;
+		std::string leftover;
+		bool eof = false;
+
+		static std::string_view trimLine(std::string_view line) {
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+			return line;
+		}
+
+	public:
+		uint64_t bytes = 0;
+
+		InputSource(const std::string& path) {
+			if (path == "-") {
+				fd = STDIN_FILENO;
+				return;
+			}
+
+			fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw std::runtime_error("can't open input file " + path + ": " + std::strerror(errno));
+			}
+			struct stat info;
+			if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+				mappedSize = size_t(info.st_size);
+				void* data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data == MAP_FAILED) {
+					throw std::runtime_error("can't map input file " + path + ": " + std::strerror(errno));
+				}
+				madvise(data, mappedSize, MADV_SEQUENTIAL);
+				mapped = static_cast<const char*>(data);
+			}
+		}
+
+		~InputSource() {
+			if (mapped) {
+				munmap(const_cast<char*>(mapped), mappedSize);
+			}
+			if (fd > STDIN_FILENO) {
+				close(fd);
+			}
+		}
+
+		// Returned views stay valid until the next call
+		bool nextBatch(std::vector<std::string_view>& lines) {
+			lines.clear();
+			if (mapped) {
+				while (lines.size() < batchLines && position < mappedSize) {
+					const char* start = mapped + position;
+					const char* end = static_cast<const char*>(std::memchr(start, '\n', mappedSize - position));
+					size_t length = end ? size_t(end - start) : mappedSize - position;
+					lines.push_back(trimLine(std::string_view(start, length)));
+					position += length + 1;
+					bytes += length + 1;
+				}
+				return !lines.empty();
+			}
+
+			buffer.swap(leftover);
+			leftover.clear();
+			size_t newlines = size_t(std::count(buffer.begin(), buffer.end(), '\n'));
+			const size_t chunk = 1 << 22;
+			while (!eof && newlines < batchLines) {
+				size_t old_size = buffer.size();
+				buffer.resize(old_size + chunk);
+				ssize_t got = read(fd, &buffer[old_size], chunk);
+				if (got < 0 && errno == EINTR) {
+					buffer.resize(old_size);
+					continue;
+				}
+				if (got < 0) {
+					throw std::runtime_error(std::string("can't read input: ") + std::strerror(errno));
+				}
+				buffer.resize(old_size + size_t(got));
+				eof = got == 0;
+				bytes += size_t(got);
+				newlines += size_t(std::count(buffer.begin() + long(old_size), buffer.end(), '\n'));
+			}
+
+			size_t start = 0;
+			while (start < buffer.size()) {
+				size_t end = buffer.find('\n', start);
+				if (end == std::string::npos) {
+					if (!eof) {
+						break;
+					}
+					end = buffer.size();
+				}
+				if (lines.size() == batchLines) {
+					break;
+				}
+				lines.push_back(trimLine(std::string_view(buffer).substr(start, end - start)));
+				start = end + 1;
+			}
+			if (start < buffer.size()) {
+				leftover.assign(buffer, start, std::string::npos);
+			}
+			return !lines.empty() || !leftover.empty();
+		}
+	};
+
+	template<typename T>
+	void writeDistribution(std::ostream& stream, const std::map<T, double>& distribution) {
+		bool first = true;
+		for (auto& i: distribution) {
+			stream << (first ? "" : ",") << i.first << ":" << i.second;
+			first = false;
+		}
+	}
+
+	// One line per expression: "failure=P decision-entropy=BITS output-entropy=BITS lengths=N:P,... | POSITION p=P world=V:P,... x=... y=... | ...",
+	// output-entropy>=BITS if it's only a lower bound
+	std::string formatAnalysis(const passlang::Analysis& analysis) {
+		std::ostringstream stream;
+		stream << "failure=" << analysis.failureProbability << " decision-entropy=" << analysis.decisionEntropy;
+		stream << (analysis.outputEntropyExact ? " output-entropy=" : " output-entropy>=") << analysis.outputEntropy << " lengths=";
+		writeDistribution(stream, analysis.lengths);
+		for (size_t i = 0; i < analysis.positions.size(); i++) {
+			stream << " | " << i << " p=" << analysis.positions[i].probability << " world=";
+			writeDistribution(stream, analysis.positions[i].world);
+			stream << " x=";
+			writeDistribution(stream, analysis.positions[i].x);
+			stream << " y=";
+			writeDistribution(stream, analysis.positions[i].y);
+		}
+		stream << "\n";
+		return stream.str();
+	}
+
+	struct LineResult {
+		std::string data;
+		uint64_t checks = 0;
+		bool failed = false;
+		std::string error;
+	};
+
+	class Worker {
+	private:
+		static const size_t arenaSize = 256 * 1024;
+
+		const Options& options;
+		const passlang::Domain& domain;
+		Random random;
+
+		// Everything of one line is allocated here and released at once before the next line
+		std::vector<char> arenaBuffer;
+		std::pmr::monotonic_buffer_resource arena;
+
+		std::function<passlang::C_Check(int, int, int)> checkConstructor;
+		std::function<int(int, int)> randrangeCallback;
+		std::function<int()> choiceCallback;
+
+	public:
+		std::vector<uint64_t> latencies;
+		uint64_t redraws = 0;
+
+		Worker(const Options& options, const passlang::Domain& domain) : options(options), domain(domain), random(options.engine), arenaBuffer(arenaSize), arena(arenaBuffer.data(), arenaBuffer.size()) {
+			// With --check-domain placeholders are already drawn from the domain by Interpreter, otherwise
+			// they are drawn the same way here and other checks aren't checked against it
+			checkConstructor = [this](int world, int x, int y) -> passlang::C_Check {
+				if (world == passlang::randomPlaceholder) {
+					const std::vector<int>& allowed = this->domain.allowedWorlds();
+					world = allowed[size_t(random.range(0, int(allowed.size()) - 1))];
+				}
+				passlang::Domain::Bounds bounds{0, this->options.coords - 1, 0, this->options.coords - 1};
+				if (this->domain.hasWorld(world)) {
+					bounds = this->domain.bounds(world);
+				}
+				if (x == passlang::randomPlaceholder) {
+					x = random.range(bounds.xStart, bounds.xFinish);
+				}
+				if (y == passlang::randomPlaceholder) {
+					y = random.range(bounds.yStart, bounds.yFinish);
+				}
+				return {world, x, y};
+			};
+			randrangeCallback = [this](int start, int finish) -> int {
+				return random.range(start, finish);
+			};
+			choiceCallback = [this]() -> int {
+				return random.range(1, 100);
+			};
+		}
+
+		void run(uint64_t lineNumber, std::string_view line, LineResult& result) {
+			auto started = std::chrono::steady_clock::now();
+			arena.release();
+
+			size_t begin = line.find_first_not_of(" \t");
+			int checksNumber = 0;
+			auto parsed = std::from_chars(line.data() + std::min(begin, line.size()), line.data() + line.size(), checksNumber);
+			std::pmr::vector<passlang::C_Check> checks(&arena);
+			if (parsed.ec != std::errc()) {
+				result.failed = true;
+				result.error = "can't read checksNumber";
+			}
+			else {
+				std::string expression(parsed.ptr, size_t(line.data() + line.size() - parsed.ptr));
+				size_t expressionStart = std::min(expression.find_first_not_of(" \t"), expression.size());
+				expression.erase(0, expressionStart);
+				size_t expressionOffset = size_t(parsed.ptr - line.data()) + expressionStart;
+
+				random.seed(options.seed, lineNumber);
+				passlang::Interpreter interpreter(checksNumber, checkConstructor, randrangeCallback, &arena);
+				interpreter.uniqueChecks = options.unique;
+				interpreter.maxRedraws = options.maxRedraws;
+				interpreter.domain = options.checkDomain ? &domain : nullptr;
+				interpreter.choiceCallback = choiceCallback;
+
+				// Rejected lines are common, so errors are taken as values instead of exceptions
+				passlang::Error error;
+				passlang::Result<passlang::Program> program = options.checkDomain ? passlang::tryCompile(expression, domain, &arena) : passlang::tryCompile(expression, &arena);
+				if (program && options.analyze) {
+					passlang::Result<passlang::Analysis> analysis = passlang::tryAnalyze(program.value(), checksNumber, interpreter.domain);
+					if (analysis) {
+						result.data = formatAnalysis(analysis.value());
+					}
+					else {
+						error = analysis.error();
+					}
+				}
+				else if (program) {
+					passlang::Result<std::pmr::vector<passlang::C_Check>> evaluated = passlang::tryEvaluate(program.value(), interpreter);
+					if (evaluated) {
+						checks = std::move(evaluated).value();
+					}
+					else {
+						error = evaluated.error();
+					}
+				}
+				else {
+					error = program.error();
+				}
+				if (error.code != passlang::ErrorCode::none) {
+					result.failed = true;
+					result.error = error.message;
+					if (error.offset != passlang::noOffset) {
+						result.error += " (column " + std::to_string(expressionOffset + error.offset + 1) + ")";
+					}
+				}
+				redraws += interpreter.redraws;
+			}
+
+			result.checks = checks.size();
+			if (options.analyze) {
+				if (result.failed) {
+					result.data = "\n";
+				}
+			}
+			else if (options.format == passlang::Serializer::Format::text) {
+				result.data.resize(passlang::Serializer::textSizeBound(checks.size()) + 1);
+				size_t written = passlang::Serializer::writeText(checks.data(), checks.size(), &result.data[0], result.data.size());
+				result.data[written] = '\n';
+				result.data.resize(written + 1);
+			}
+			else {
+				result.data.resize(passlang::Serializer::binarySize(checks.size()));
+				passlang::Serializer::writeBinary(checks.data(), checks.size(), &result.data[0], result.data.size());
+			}
+
+			auto elapsed = std::chrono::steady_clock::now() - started;
+			latencies.push_back(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+	};
+
+	// Threads of workers except the first one live for the whole input and wait for batches,
+	// the calling thread runs the first worker
+	class WorkerPool {
+	private:
+		std::vector<std::unique_ptr<Worker>>& workers;
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable batchStarted, batchFinished;
+		std::function<void(Worker&)> task;
+		uint64_t batch = 0;
+		size_t running = 0;
+		bool stopping = false;
+
+		void loop(Worker& worker) {
+			uint64_t done = 0;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				batchStarted.wait(lock, [&] { return stopping || batch != done; });
+				if (stopping) {
+					return;
+				}
+				done = batch;
+				lock.unlock();
+				task(worker);
+				lock.lock();
+				if (--running == 0) {
+					batchFinished.notify_one();
+				}
+			}
+		}
+
+	public:
+		WorkerPool(std::vector<std::unique_ptr<Worker>>& workers) : workers(workers) {
+			for (size_t i = 1; i < workers.size(); i++) {
+				threads.emplace_back(&WorkerPool::loop, this, std::ref(*workers[i]));
+			}
+		}
+
+		~WorkerPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			batchStarted.notify_all();
+			for (auto& thread: threads) {
+				thread.join();
+			}
+		}
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		// Returns when every worker has finished the task
+		void run(std::function<void(Worker&)> batchTask) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				task = std::move(batchTask);
+				running = threads.size();
+				batch++;
+			}
+			batchStarted.notify_all();
+			task(*workers[0]);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			batchFinished.wait(lock, [&] { return running == 0; });
+		}
+	};
+
+	uint64_t percentile(std::vector<uint64_t>& values, double fraction) {
+		if (values.empty()) {
+			return 0;
+		}
+		size_t index = std::min(values.size() - 1, size_t(fraction * double(values.size())));
+		std::nth_element(values.begin(), values.begin() + long(index), values.end());
+		return values[index];
+	}
+
+	void printUsage(const char* name) {
+		std::cerr << "Usage: " << name << " [options]\n"
+			"  -i, --input FILE       input with \"checksNumber expression\" lines (default: stdin)\n"
+			"  -o, --output FILE      output file (default: stdout)\n"
+			"  -f, --format FORMAT    text or binary (default: text)\n"
+			"  -s, --seed N           base seed, every line is seeded from it and its number (default: time)\n"
+			"  -e, --engine ENGINE    mt19937, mt19937_64 or minstd (default: mt19937)\n"
+			"  -j, --threads N        worker threads (default: all cores)\n"
+			"      --worlds N         number of worlds for random placeholders, 0..N-1 (default: 10)\n"
+			"      --coords N         x and y range of random placeholders, 0..N-1 (default: 2048)\n"
+			"      --exclude W,W...   worlds which random placeholders never take\n"
+			"      --world-bounds W:XS-XF:YS-YF\n"
+			"                         x and y bounds of world W, both ends included (repeatable)\n"
+			"      --check-domain     reject checks whose world, x or y is out of the worlds and bounds above\n"
+			"      --unique           no repeated (world, x, y) checks in one expression's result\n"
+			"      --max-redraws N    redraws of one repeated check before failing (default: 1000)\n"
+			"      --report           print throughput and latency report to stderr\n"
+			"      --analyze          print exact distributions of every expression's results instead of sampling them\n";
+	}
+
+	template<typename T>
+	T parseNumber(const std::string& option, const std::string& value) {
+		T number{};
+		auto parsed = std::from_chars(value.data(), value.data() + value.size(), number);
+		if (parsed.ec != std::errc() || parsed.ptr != value.data() + value.size()) {
+			throw std::runtime_error("invalid value for " + option + ": " + value);
+		}
+		return number;
+	}
+
+	// Splits value by separator, a part may be empty
+	std::vector<std::string> split(const std::string& value, char separator) {
+		std::vector<std::string> parts;
+		size_t start = 0;
+		for (size_t end = value.find(separator); end != std::string::npos; end = value.find(separator, start)) {
+			parts.push_back(value.substr(start, end - start));
+			start = end + 1;
+		}
+		parts.push_back(value.substr(start));
+		return parts;
+	}
+
+	// "W:XS-XF:YS-YF"
+	WorldBounds parseWorldBounds(const std::string& option, const std::string& value) {
+		std::vector<std::string> parts = split(value, ':');
+		if (parts.size() != 3) {
+			throw std::runtime_error("invalid value for " + option + ": " + value + ", expected W:XS-XF:YS-YF");
+		}
+		std::vector<std::string> x = split(parts[1], '-');
+		std::vector<std::string> y = split(parts[2], '-');
+		if (x.size() != 2 || y.size() != 2) {
+			throw std::runtime_error("invalid value for " + option + ": " + value + ", expected W:XS-XF:YS-YF");
+		}
+		return WorldBounds{parseNumber<int>(option, parts[0]), passlang::Domain::Bounds{parseNumber<int>(option, x[0]), parseNumber<int>(option, x[1]), parseNumber<int>(option, y[0]), parseNumber<int>(option, y[1])}};
+	}
+
+	// Raises on excluded or bounded world out of --worlds, on bad bounds and on excluding every world
+	passlang::Domain makeDomain(const Options& options) {
+		passlang::Domain domain(options.worlds, 0, options.coords - 1);
+		for (auto& i: options.worldBounds) {
+			domain.setBounds(i.world, i.bounds.xStart, i.bounds.xFinish, i.bounds.yStart, i.bounds.yFinish);
+		}
+		for (int i: options.excluded) {
+			domain.exclude(i);
+		}
+		return domain;
+	}
+
+	Options parseOptions(int argc, char** args) {
+		Options options;
+		options.seed = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+
+		for (int i = 1; i < argc; i++) {
+			std::string option = args[i];
+			if (option == "-h" || option == "--help") {
+				printUsage(args[0]);
+				std::exit(0);
+			}
+			if (option == "--report") {
+				options.report = true;
+				continue;
+			}
+			if (option == "--unique") {
+				options.unique = true;
+				continue;
+			}
+			if (option == "--analyze") {
+				options.analyze = true;
+				continue;
+			}
+			if (option == "--check-domain") {
+				options.checkDomain = true;
+				continue;
+			}
+			if (i + 1 >= argc) {
+				throw std::runtime_error("missing value for " + option);
+			}
+			std::string value = args[++i];
+
+			if (option == "-i" || option == "--input") {
+				options.input = value;
+			}
+			else if (option == "-o" || option == "--output") {
+				options.output = value;
+			}
+			else if (option == "-f" || option == "--format") {
+				if (value == "text") {
+					options.format = passlang::Serializer::Format::text;
+				}
+				else if (value == "binary") {
+					options.format = passlang::Serializer::Format::binary;
+				}
+				else {
+					throw std::runtime_error("unknown format: " + value);
+				}
+			}
+			else if (option == "-s" || option == "--seed") {
+				options.seed = parseNumber<uint64_t>(option, value);
+			}
+			else if (option == "-e" || option == "--engine") {
+				if (value == "mt19937") {
+					options.engine = Engine::mt19937;
+				}
+				else if (value == "mt19937_64") {
+					options.engine = Engine::mt19937_64;
+				}
+				else if (value == "minstd") {
+					options.engine = Engine::minstd;
+				}
+				else {
+					throw std::runtime_error("unknown engine: " + value);
+				}
+			}
+			else if (option == "-j" || option == "--threads") {
+				options.threads = parseNumber<unsigned>(option, value);
+			}
+			else if (option == "--worlds") {
+				options.worlds = parseNumber<int>(option, value);
+			}
+			else if (option == "--coords") {
+				options.coords = parseNumber<int>(option, value);
+			}
+			else if (option == "--exclude") {
+				for (auto& i: split(value, ',')) {
+					options.excluded.push_back(parseNumber<int>(option, i));
+				}
+			}
+			else if (option == "--world-bounds") {
+				options.worldBounds.push_back(parseWorldBounds(option, value));
+			}
+			else if (option == "--max-redraws") {
+				options.maxRedraws = parseNumber<size_t>(option, value);
+			}
+			else {
+				throw std::runtime_error("unknown option: " + option);
+			}
+		}
+
+		if (options.worlds <= 0 || options.coords <= 0) {
+			throw std::runtime_error("--worlds and --coords must be positive");
+		}
+		if (!options.threads) {
+			options.threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		return options;
+	}
+}
+
+
+int main(int argc, char** args) {
+	Options options;
+	std::unique_ptr<passlang::Domain> domain;
+	try {
+		options = parseOptions(argc, args);
+		domain = std::make_unique<passlang::Domain>(makeDomain(options));
+	}
+	catch (const std::exception& exception) {
+		std::cerr << args[0] << ": " << exception.what() << "\n";
+		printUsage(args[0]);
+		return 2;
+	}
+
+	try {
+		InputSource input(options.input);
+
+		int outputFd = STDOUT_FILENO;
+		if (options.output != "-") {
+			outputFd = open(options.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (outputFd < 0) {
+				throw std::runtime_error("can't open output file " + options.output + ": " + std::strerror(errno));
+			}
+		}
+
+		// Workers are captured by their own callbacks, so they must not move
+		std::vector<std::unique_ptr<Worker>> workers;
+		for (unsigned i = 0; i < options.threads; i++) {
+			workers.push_back(std::make_unique<Worker>(options, *domain));
+		}
+		WorkerPool pool(workers);
+
+		uint64_t lineNumber = 0, evaluated = 0, errors = 0, checks = 0;
+		auto started = std::chrono::steady_clock::now();
+		{
+			passlang::Serializer::FdWriter writer(outputFd);
+			std::vector<std::string_view> lines;
+			std::vector<uint64_t> numbers;
+			std::vector<LineResult> results;
+
+			while (input.nextBatch(lines)) {
+				// Blank lines are skipped, but keep their numbers for seeding and error messages
+				numbers.clear();
+				size_t kept = 0;
+				for (size_t i = 0; i < lines.size(); i++) {
+					lineNumber++;
+					if (lines[i].find_first_not_of(" \t") != std::string_view::npos) {
+						lines[kept++] = lines[i];
+						numbers.push_back(lineNumber);
+					}
+				}
+				lines.resize(kept);
+				results.assign(lines.size(), LineResult());
+
+				std::atomic<size_t> next(0);
+				auto work = [&](Worker& worker) {
+					for (size_t start = next.fetch_add(workChunk); start < lines.size(); start = next.fetch_add(workChunk)) {
+						size_t end = std::min(lines.size(), start + workChunk);
+						for (size_t i = start; i < end; i++) {
+							worker.run(numbers[i], lines[i], results[i]);
+						}
+					}
+				};
+				pool.run(work);
+
+				for (size_t i = 0; i < results.size(); i++) {
+					if (results[i].failed) {
+						errors++;
+						std::cerr << "line " << numbers[i] << ": " << results[i].error << "\n";
+					}
+					checks += results[i].checks;
+					writer.writeRaw(results[i].data.data(), results[i].data.size());
+				}
+				evaluated += results.size();
+			}
+			writer.flush();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+		if (outputFd != STDOUT_FILENO) {
+			close(outputFd);
+		}
+
+		if (options.report) {
+			std::vector<uint64_t> latencies;
+			uint64_t redraws = 0;
+			for (auto& worker: workers) {
+				latencies.insert(latencies.end(), worker->latencies.begin(), worker->latencies.end());
+				redraws += worker->redraws;
+			}
+			uint64_t p50 = percentile(latencies, 0.50);
+			uint64_t p99 = percentile(latencies, 0.99);
+			seconds = std::max(seconds, 1e-9);
+
+			std::cerr << "expressions: " << evaluated << " (" << errors << " failed)\n"
+				<< "checks:      " << checks << "\n"
+				<< "redraws:     " << redraws << "\n"
+				<< "threads:     " << options.threads << "\n"
+				<< "time:        " << seconds << " s\n"
+				<< "throughput:  " << double(evaluated) / seconds << " expressions/s, "
+				<< double(checks) / seconds << " checks/s, "
+				<< double(input.bytes) / seconds / 1e6 << " MB/s input\n"
+				<< "latency:     p50 " << double(p50) / 1e3 << " us, p99 " << double(p99) / 1e3 << " us\n";
+		}
+		return errors ? 1 : 0;
+	}
+	catch (const std::exception& exception) {
+		std::cerr << args[0] << ": " << exception.what() << "\n";
+		return 1;
+	}
+}
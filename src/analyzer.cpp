@@ -0,0 +1,14 @@
+#include "analyzer.h"
+
+
+namespace passlang {
+	Result<Analysis> tryAnalyze(const Program& program, int numberOfChecks, const Domain* domain) {
+		Analyzer analyzer(numberOfChecks);
+		analyzer.domain = domain;
+		return analyzer.tryAnalyze(program.checks);
+	}
+
+	Analysis analyze(const Program& program, int numberOfChecks, const Domain* domain) {
+		return tryAnalyze(program, numberOfChecks, domain).value();
+	}
+}
@@ -0,0 +1,811 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include "passlang.h"
+
+
+namespace passlang {
+	/************* ANALYZER *************/
+	// Distribution of values of one position of the sequence, conditional on a check being there
+	struct PositionDistribution {
+		double probability = 0;		// sequence has a check at this position
+		std::map<int, double> world;
+		std::map<int, double> x;
+		std::map<int, double> y;
+	};
+
+	// Distributions are conditional on successful evaluation
+	struct Analysis {
+		double failureProbability = 0;				// evaluation ends with an error
+		std::map<size_t, double> lengths;			// number of checks
+		std::vector<PositionDistribution> positions;	// first maxPositions positions of the sequence
+
+		// Bits of random decisions: ranges and chosen elements of random choices. Different decisions may give
+		// the same checks, so it's only an upper bound of outputEntropy
+		double decisionEntropy = 0;
+
+		// Shannon entropy of the whole sequence of checks. Exact while there are at most maxSupport possible
+		// sequences of at most maxPositions checks, otherwise it's a lower bound: the largest entropy of length
+		// and of world, x or y of one position
+		double outputEntropy = 0;
+		bool outputEntropyExact = false;
+	};
+
+	// Computes exact distributions of Interpreter results for fixed numberOfChecks without sampling.
+	// Random ranges are uniform, random choices use the same float arithmetic as Interpreter::eval(RandomChoice)
+	// for every random value 1..100. Without domain random placeholders are decided by checkConstructor, they are
+	// reported as randomPlaceholder and aren't counted in entropies. With domain they are uniform like in Interpreter,
+	// and checks out of the domain are failures. Uniqueness mode isn't modelled. Chances of random choices
+	// must be constant in their context, and distributions and work are bounded by the limits below
+	class Analyzer {
+	private:
+		// Probability of the value and sum of P(path) * bits of decisions over paths to it
+		struct Outcome {
+			double probability = 0;
+			double decisionEntropy = 0;
+		};
+		typedef std::map<int, Outcome> Value; // missing probability mass is evaluation failure
+
+		// Probabilities are joint with success, so lengths and positions sum up to the success probability
+		struct Sequence {
+			std::map<size_t, double> lengths;
+			std::vector<PositionDistribution> positions;
+			double decisionEntropy = 0;
+
+			// Whole sequences as world, x, y of every check, kept while outputsExact. Dropped when they get too many,
+			// too long or too much work, it doesn't fail the analysis
+			std::map<std::vector<int>, double> outputs;
+			bool outputsExact = true;
+		};
+
+		// Probabilities of chosen elements of random choice, the rest of mass fails
+		struct Choice {
+			std::vector<double> probabilities;
+			double none = 0; // nothing is chosen
+		};
+
+		std::vector<int> loopIterators;
+		size_t steps = 0;
+		size_t outputSteps = 0; // work on Sequence::outputs, limited by maxSteps separately
+
+		void fail(ErrorCode code, std::string message) {
+			if (!failed()) {
+				error = Error{code, noOffset, message};
+			}
+		}
+
+		bool step(size_t count = 1) {
+			steps += count;
+			if (steps > maxSteps) {
+				fail(ErrorCode::analysisLimit, "Analyzer: program needs more than " + std::to_string(maxSteps) + " steps to analyze");
+			}
+			return !failed();
+		}
+
+		bool checkSupport(const Value& value) {
+			if (value.size() > maxSupport) {
+				fail(ErrorCode::analysisLimit, "Analyzer: value has more than " + std::to_string(maxSupport) + " possible results");
+			}
+			return !failed();
+		}
+
+		static double surprisal(double probability) {
+			return probability > 0 ? -std::log2(probability) : 0;
+		}
+
+		static double mass(const Value& value) {
+			double sum = 0;
+			for (auto& i: value) {
+				sum += i.second.probability;
+			}
+			return sum;
+		}
+
+		static double decisionEntropy(const Value& value) {
+			double sum = 0;
+			for (auto& i: value) {
+				sum += i.second.decisionEntropy;
+			}
+			return sum;
+		}
+
+		static double mass(const Sequence& sequence) {
+			double sum = 0;
+			for (auto& i: sequence.lengths) {
+				sum += i.second;
+			}
+			return sum;
+		}
+
+		static Value constant(int number) {
+			return Value{{number, Outcome{1, 0}}};
+		}
+
+		static Sequence empty() {
+			Sequence sequence;
+			sequence.lengths[0] = 1;
+			sequence.outputs[{}] = 1;
+			return sequence;
+		}
+
+		static void dropOutputs(Sequence& sequence) {
+			sequence.outputs.clear();
+			sequence.outputsExact = false;
+		}
+
+		// Counts work on outputs of the sequence, drops them if they are over the limits
+		void checkOutputs(Sequence& sequence, size_t work) {
+			outputSteps += work;
+			if (outputSteps > maxSteps || sequence.outputs.size() > maxSupport) {
+				dropOutputs(sequence);
+			}
+		}
+
+		// Shannon entropy of probabilities which sum up to total
+		template<typename T>
+		static double shannon(const T& values, double total) {
+			double sum = 0;
+			for (auto& i: values) {
+				if (i.second > 0) {
+					sum -= i.second / total * std::log2(i.second / total);
+				}
+			}
+			return sum;
+		}
+
+		// Entropy of the value at the position, being absent is one more outcome
+		static double positionShannon(const std::map<int, double>& values, double probability) {
+			double sum = probability < 1 ? -(1 - probability) * std::log2(1 - probability) : 0;
+			for (auto& i: values) {
+				double outcome = i.second * probability;
+				if (outcome > 0) {
+					sum -= outcome * std::log2(outcome);
+				}
+			}
+			return sum;
+		}
+
+		// Value is the same on every path, false if it's random or evaluation may fail
+		static bool isConstant(const Value& value, int& number) {
+			if (value.size() != 1 || value.begin()->second.probability < 1 - 1e-9) {
+				return false;
+			}
+			number = value.begin()->first;
+			return true;
+		}
+
+		static void addScaled(std::map<int, double>& to, const std::map<int, double>& from, double weight) {
+			for (auto& i: from) {
+				to[i.first] += i.second * weight;
+			}
+		}
+
+		static void addScaled(PositionDistribution& to, const PositionDistribution& from, double weight) {
+			to.probability += from.probability * weight;
+			addScaled(to.world, from.world, weight);
+			addScaled(to.x, from.x, weight);
+			addScaled(to.y, from.y, weight);
+		}
+
+		void addScaled(Sequence& to, const Sequence& from, double weight) {
+			for (auto& i: from.lengths) {
+				to.lengths[i.first] += i.second * weight;
+			}
+			if (to.positions.size() < from.positions.size()) {
+				to.positions.resize(from.positions.size());
+			}
+			for (size_t i = 0; i < from.positions.size() && step(); i++) {
+				addScaled(to.positions[i], from.positions[i], weight);
+			}
+			to.decisionEntropy += from.decisionEntropy * weight;
+
+			if (!from.outputsExact) {
+				dropOutputs(to);
+			}
+			else if (to.outputsExact) {
+				for (auto& i: from.outputs) {
+					to.outputs[i.first] += i.second * weight;
+				}
+				checkOutputs(to, from.outputs.size());
+			}
+		}
+
+		static void scale(std::map<int, double>& values, double weight) {
+			for (auto& i: values) {
+				i.second *= weight;
+			}
+		}
+
+		// Appends independent second sequence to the first one
+		void append(Sequence& first, const Sequence& second) {
+			double firstMass = mass(first), secondMass = mass(second);
+			first.decisionEntropy = first.decisionEntropy * secondMass + firstMass * second.decisionEntropy;
+
+			std::map<size_t, double> lengths;
+			for (auto& i: first.lengths) {
+				for (auto& j: second.lengths) {
+					lengths[i.first + j.first] += i.second * j.second;
+				}
+				if (!step(1 + second.lengths.size())) {
+					return;
+				}
+			}
+
+			if (secondMass < 1) {
+				for (auto& i: first.positions) {
+					i.probability *= secondMass;
+					scale(i.world, secondMass);
+					scale(i.x, secondMass);
+					scale(i.y, secondMass);
+				}
+				step(first.positions.size());
+			}
+			for (auto& i: first.lengths) {
+				if (i.first >= maxPositions) {
+					break;
+				}
+				for (size_t j = 0; j < second.positions.size() && i.first + j < maxPositions; j++) {
+					if (first.positions.size() <= i.first + j) {
+						first.positions.resize(i.first + j + 1);
+					}
+					addScaled(first.positions[i.first + j], second.positions[j], i.second);
+				}
+				if (!step(second.positions.size())) {
+					return;
+				}
+			}
+			first.lengths.swap(lengths);
+
+			if (!first.outputsExact || !second.outputsExact || first.outputs.size() * second.outputs.size() > maxSupport) {
+				dropOutputs(first);
+				return;
+			}
+			std::map<std::vector<int>, double> outputs;
+			size_t work = 0;
+			for (auto& i: first.outputs) {
+				for (auto& j: second.outputs) {
+					if (i.first.size() + j.first.size() > 3 * maxPositions) {
+						dropOutputs(first);
+						return;
+					}
+					std::vector<int> output = i.first;
+					output.insert(output.end(), j.first.begin(), j.first.end());
+					outputs[output] += i.second * j.second;
+					work += output.size();
+				}
+			}
+			first.outputs.swap(outputs);
+			checkOutputs(first, work);
+		}
+
+		static int calculate(int first, const std::string& operation, int second) {
+			// Interpreter calculates in int, its overflow is taken as wrapping
+			uint32_t a = uint32_t(first), b = uint32_t(second);
+			if (operation == "+") {
+				return int(a + b);
+			}
+			else if (operation == "-") {
+				return int(a - b);
+			}
+			else if (operation == "*") {
+				return int(a * b);
+			}
+			else if (operation == "/") {
+				return first / second;
+			}
+			return first % second;
+		}
+
+	public:
+		static const size_t defaultMaxPositions = 64;
+		static const size_t defaultMaxSupport = 1 << 16;
+		static const size_t defaultMaxSteps = 1 << 26;
+
+		int numberOfChecks;
+		size_t maxPositions = defaultMaxPositions;
+		size_t maxSupport = defaultMaxSupport;	// possible results of one value
+		size_t maxSteps = defaultMaxSteps;		// elementary operations of the whole analysis
+		const Domain* domain = nullptr;			// not owned
+
+		Error error;
+
+		Analyzer(int numberOfChecks) {
+			this->numberOfChecks = numberOfChecks;
+		}
+
+		bool failed() const {
+			return error.code != ErrorCode::none;
+		}
+
+		Result<Analysis> tryAnalyze(const std::pmr::vector<ChecksRowElement>& checks) {
+			error = Error();
+			loopIterators.clear();
+			steps = 0;
+			outputSteps = 0;
+
+			Sequence sequence = empty();
+			for (auto i: checks) {
+				append(sequence, eval(i));
+				if (failed()) {
+					return error;
+				}
+			}
+
+			Analysis analysis;
+			double success = mass(sequence);
+			analysis.failureProbability = std::max(0.0, 1 - success);
+			if (success <= 0) {
+				return analysis;
+			}
+
+			for (auto& i: sequence.lengths) {
+				if (i.second > 0) {
+					analysis.lengths[i.first] = i.second / success;
+				}
+			}
+			for (auto& i: sequence.positions) {
+				PositionDistribution position;
+				position.probability = i.probability / success;
+				if (i.probability > 0) {
+					addScaled(position.world, i.world, 1 / i.probability);
+					addScaled(position.x, i.x, 1 / i.probability);
+					addScaled(position.y, i.y, 1 / i.probability);
+				}
+				analysis.positions.push_back(position);
+			}
+			analysis.decisionEntropy = sequence.decisionEntropy / success;
+
+			analysis.outputEntropyExact = sequence.outputsExact;
+			if (sequence.outputsExact) {
+				analysis.outputEntropy = shannon(sequence.outputs, success);
+			}
+			else {
+				analysis.outputEntropy = shannon(analysis.lengths, 1.0);
+				for (auto& i: analysis.positions) {
+					analysis.outputEntropy = std::max({analysis.outputEntropy, positionShannon(i.world, i.probability), positionShannon(i.x, i.probability), positionShannon(i.y, i.probability)});
+				}
+			}
+			return analysis;
+		}
+
+		Analysis analyze(const std::pmr::vector<ChecksRowElement>& checks) {
+			return tryAnalyze(checks).value();
+		}
+
+		Sequence eval(ChecksRowElement check) {
+			if (check.type == ChecksRowElementType::check) {
+				return eval(check.get<Check>());
+			}
+			else if (check.type == ChecksRowElementType::loop) {
+				return eval(check.get<Loop>());
+			}
+			else if (check.type == ChecksRowElementType::randomcheckchoice) {
+				const RandomChoice& randomChoice = check.get<RandomChoice>();
+				Choice choice = choose(randomChoice);
+
+				Sequence sequence;
+				for (size_t i = 0; i < choice.probabilities.size() && !failed(); i++) {
+					if (choice.probabilities[i] > 0) {
+						Sequence chosen = eval(randomChoice.choices[i].value.get<ChecksRowElement>());
+						addScaled(sequence, chosen, choice.probabilities[i]);
+						sequence.decisionEntropy += choice.probabilities[i] * mass(chosen) * surprisal(choice.probabilities[i]);
+					}
+				}
+				if (choice.none > 0) {
+					addScaled(sequence, empty(), choice.none);
+					sequence.decisionEntropy += choice.none * surprisal(choice.none);
+				}
+				return sequence;
+			}
+
+			fail(ErrorCode::invalidNode, "Analyzer::evalChecksRowElement: can't use given ChecksRowElement");
+			return {};
+		}
+
+		Sequence eval(const Check& check) {
+			Value world = eval(check.world);
+			Value x = eval(check.x);
+			Value y = eval(check.y);
+			if (failed()) {
+				return {};
+			}
+
+			Sequence sequence;
+			PositionDistribution position;
+			if (!domain) {
+				addCheck(sequence, position, world, x, y);
+			}
+			else {
+				// Bounds of x and y depend on the world, so every world is added separately
+				Value resolvedWorld = resolveWorld(world);
+				for (auto& i: resolvedWorld) {
+					if (failed()) {
+						return {};
+					}
+					const Domain::Bounds& bounds = domain->bounds(i.first);
+					addCheck(sequence, position, Value{i}, resolveCoordinate(x, bounds.xStart, bounds.xFinish), resolveCoordinate(y, bounds.yStart, bounds.yFinish));
+				}
+				if (failed()) {
+					return {};
+				}
+			}
+			if (maxPositions) {
+				sequence.positions.push_back(position);
+			}
+			return sequence;
+		}
+
+		// Adds check with independent world, x and y to the sequence of one check
+		void addCheck(Sequence& sequence, PositionDistribution& position, const Value& world, const Value& x, const Value& y) {
+			double worldMass = mass(world), xMass = mass(x), yMass = mass(y);
+			double checkMass = worldMass * xMass * yMass;
+
+			sequence.lengths[1] += checkMass;
+			sequence.decisionEntropy += decisionEntropy(world) * xMass * yMass + worldMass * decisionEntropy(x) * yMass + worldMass * xMass * decisionEntropy(y);
+			if (maxPositions) {
+				position.probability += checkMass;
+				for (auto& i: world) {
+					position.world[i.first] += i.second.probability * xMass * yMass;
+				}
+				for (auto& i: x) {
+					position.x[i.first] += i.second.probability * worldMass * yMass;
+				}
+				for (auto& i: y) {
+					position.y[i.first] += i.second.probability * worldMass * xMass;
+				}
+			}
+			step(world.size() + x.size() + y.size());
+
+			if (!sequence.outputsExact || world.size() * x.size() * y.size() > maxSupport) {
+				dropOutputs(sequence);
+				return;
+			}
+			for (auto& i: world) {
+				for (auto& j: x) {
+					for (auto& k: y) {
+						sequence.outputs[{i.first, j.first, k.first}] += i.second.probability * j.second.probability * k.second.probability;
+					}
+				}
+			}
+			checkOutputs(sequence, world.size() * x.size() * y.size());
+		}
+
+		// World with placeholder drawn uniformly from allowed worlds, worlds out of the domain fail
+		Value resolveWorld(const Value& world) {
+			const std::vector<int>& allowed = domain->allowedWorlds();
+			Value value;
+			for (auto& i: world) {
+				if (i.first == randomPlaceholder) {
+					Outcome share = uniformShare(i.second, allowed.size());
+					for (int j: allowed) {
+						add(value[j], share);
+					}
+				}
+				else if (domain->hasWorld(i.first)) {
+					add(value[i.first], i.second);
+				}
+			}
+			step(world.size() + allowed.size());
+			return value;
+		}
+
+		// Coordinate with placeholder drawn uniformly from start..finish, values out of them fail
+		Value resolveCoordinate(const Value& coordinate, int start, int finish) {
+			Value value;
+			for (auto& i: coordinate) {
+				if (i.first == randomPlaceholder) {
+					long long size = (long long)finish - start + 1;
+					if (size_t(size) > maxSupport) {
+						fail(ErrorCode::analysisLimit, "Analyzer::resolveCoordinate: bounds " + std::to_string(start) + "-" + std::to_string(finish) + " have more than " + std::to_string(maxSupport) + " values");
+						return {};
+					}
+					Outcome share = uniformShare(i.second, size_t(size));
+					for (long long k = start; k <= finish; k++) {
+						add(value[int(k)], share);
+					}
+					step(size_t(size));
+				}
+				else if (i.first >= start && i.first <= finish) {
+					add(value[i.first], i.second);
+				}
+			}
+			step(coordinate.size());
+			checkSupport(value);
+			return value;
+		}
+
+		// Part of outcome which goes to one of size equally likely values, the draw adds its bits to entropy
+		static Outcome uniformShare(const Outcome& outcome, size_t size) {
+			return Outcome{outcome.probability / double(size), (outcome.decisionEntropy + outcome.probability * std::log2(double(size))) / double(size)};
+		}
+
+		static void add(Outcome& to, const Outcome& from) {
+			to.probability += from.probability;
+			to.decisionEntropy += from.decisionEntropy;
+		}
+
+		// Mixture of loops of every possible length, built while iterations are appended one by one
+		Sequence eval(const Loop& loop) {
+			Value length = eval(loop.length);
+			if (failed()) {
+				return {};
+			}
+
+			Sequence sequence;
+			int maxLength = 0;
+			for (auto& i: length) {
+				if (i.first <= 0 || loop.checks.empty()) {
+					addScaled(sequence, empty(), i.second.probability);
+					sequence.decisionEntropy += i.second.decisionEntropy;
+				}
+				maxLength = std::max(maxLength, i.first);
+			}
+			if (loop.checks.empty()) {
+				return sequence;
+			}
+
+			long long bodyLength = (long long)loop.checks.size();
+			if ((long long)maxLength * bodyLength > INT_MAX) {
+				fail(ErrorCode::analysisLimit, "Analyzer::evalLoop: loop iterator doesn't fit int");
+				return {};
+			}
+
+			loopIterators.push_back(0);
+			Sequence iterations = empty();
+			for (int j = 0; j < maxLength && !failed(); j++) {
+				for (size_t i = 0; i < loop.checks.size() && !failed(); i++) {
+					loopIterators.back() = int(j * bodyLength + (long long)i);
+					append(iterations, eval(loop.checks[i]));
+				}
+
+				auto iterationsLength = length.find(j + 1);
+				if (iterationsLength != length.end() && !failed()) {
+					addScaled(sequence, iterations, iterationsLength->second.probability);
+					sequence.decisionEntropy += iterationsLength->second.decisionEntropy * mass(iterations);
+				}
+			}
+			loopIterators.pop_back();
+
+			if (failed()) {
+				return {};
+			}
+			return sequence;
+		}
+
+		Value eval(CheckElement checkElement) {
+			if (checkElement.type == CheckElementType::number) {
+				return constant(checkElement.get<int>());
+			}
+			else if (checkElement.type == CheckElementType::expression) {
+				return eval(checkElement.get<ExpressionNode>());
+			}
+			else if (checkElement.type == CheckElementType::random) {
+				return constant(randomPlaceholder);
+			}
+			else if (checkElement.type == CheckElementType::randomrange) {
+				return eval(checkElement.get<RandomRange>());
+			}
+			else if (checkElement.type == CheckElementType::randomchoice) {
+				return eval(checkElement.get<RandomChoice>());
+			}
+			else if (checkElement.type == CheckElementType::numofchecks) {
+				return constant(numberOfChecks);
+			}
+			else if (checkElement.type == CheckElementType::loopiterator) {
+				return getIterator(checkElement.get<int>());
+			}
+			fail(ErrorCode::invalidNode, "Analyzer::evalCheckElement: can't use given CheckElement");
+			return {};
+		}
+
+		Value eval(Operand operand) {
+			if (operand.type == OperandType::number) {
+				return constant(operand.get<int>());
+			}
+			else if (operand.type == OperandType::expression) {
+				return eval(operand.get<ExpressionNode>());
+			}
+			else if (operand.type == OperandType::randomrange) {
+				return eval(operand.get<RandomRange>());
+			}
+			else if (operand.type == OperandType::randomchoice) {
+				return eval(operand.get<RandomChoice>());
+			}
+			else if (operand.type == OperandType::numofchecks) {
+				return constant(numberOfChecks);
+			}
+			else if (operand.type == OperandType::loopiterator) {
+				return getIterator(operand.get<int>());
+			}
+			fail(ErrorCode::invalidNode, "Analyzer::evalOperand: can't use given Operand");
+			return {};
+		}
+
+		Value eval(const ExpressionNode& expression) {
+			Value first = eval(expression.firstOperand);
+			Value second = eval(expression.secondOperand);
+			if (failed()) {
+				return {};
+			}
+			if (expression.operation != "+" && expression.operation != "-" && expression.operation != "*" && expression.operation != "/" && expression.operation != "%") {
+				fail(ErrorCode::unknownOperator, std::string("Analyzer::evalExpression: can't use given operator: ") + expression.operation);
+				return {};
+			}
+
+			Value value;
+			bool division = expression.operation == "/" || expression.operation == "%";
+			for (auto& i: first) {
+				for (auto& j: second) {
+					if (division && (j.first == 0 || (i.first == INT_MIN && j.first == -1))) {
+						continue; // evaluation fails
+					}
+					Outcome& outcome = value[calculate(i.first, expression.operation, j.first)];
+					outcome.probability += i.second.probability * j.second.probability;
+					outcome.decisionEntropy += i.second.decisionEntropy * j.second.probability + i.second.probability * j.second.decisionEntropy;
+				}
+				// Checked on every row, so a product far over the limits stops early
+				if (!step(second.size()) || !checkSupport(value)) {
+					return {};
+				}
+			}
+			return value;
+		}
+
+		Value eval(const RandomRange& randomRange) {
+			Value start = eval(randomRange.start);
+			Value finish = eval(randomRange.finish);
+			if (failed()) {
+				return {};
+			}
+
+			Value value;
+			for (auto& i: start) {
+				for (auto& j: finish) {
+					long long low = std::min(i.first, j.first), high = std::max(i.first, j.first);
+					long long size = high - low + 1;
+					if (size_t(size) > maxSupport) {
+						fail(ErrorCode::analysisLimit, "Analyzer::evalRandomRange: range " + std::to_string(low) + "-" + std::to_string(high) + " has more than " + std::to_string(maxSupport) + " values");
+						return {};
+					}
+
+					double probability = i.second.probability * j.second.probability / double(size);
+					double entropy = (i.second.decisionEntropy * j.second.probability + i.second.probability * j.second.decisionEntropy) / double(size) + probability * std::log2(double(size));
+					for (long long k = low; k <= high; k++) {
+						Outcome& outcome = value[int(k)];
+						outcome.probability += probability;
+						outcome.decisionEntropy += entropy;
+					}
+					if (!step(size_t(size)) || !checkSupport(value)) {
+						return {};
+					}
+				}
+			}
+			return value;
+		}
+
+		Value eval(const RandomChoice& randomChoice) {
+			Choice choice = choose(randomChoice);
+
+			Value value;
+			for (size_t i = 0; i < choice.probabilities.size() && !failed(); i++) {
+				double probability = choice.probabilities[i];
+				if (probability <= 0) {
+					continue;
+				}
+				Value chosen = eval(randomChoice.choices[i].value.get<Operand>());
+				for (auto& j: chosen) {
+					Outcome& outcome = value[j.first];
+					outcome.probability += probability * j.second.probability;
+					outcome.decisionEntropy += probability * (j.second.decisionEntropy + j.second.probability * surprisal(probability));
+				}
+			}
+			if (failed()) {
+				return {};
+			}
+			checkSupport(value);
+			return value; // nothing chosen is a failure for operands
+		}
+
+		// Replica of Interpreter::eval(RandomChoice) for every random value 1..100
+		Choice choose(const RandomChoice& randomChoice) {
+			Choice failure;
+			failure.probabilities.assign(randomChoice.choices.size(), 0);
+			Choice choice = failure;
+
+			std::vector<int> chances(randomChoice.choices.size(), 0);
+			int freeChance = 100;
+			int freeElements = 0;
+			for (size_t i = 0; i < randomChoice.choices.size(); i++) {
+				const RandomChoiceElement& element = randomChoice.choices[i];
+				if (element.equals.type == RandomChoiceChanceType::operand) {
+					int chance, equals;
+					Value chanceValue = eval(element.chance.get<Operand>());
+					Value equalsValue = eval(element.equals.get<Operand>());
+					if (failed() || chanceValue.empty() || equalsValue.empty()) {
+						return failure;
+					}
+					if (!isConstant(chanceValue, chance) || !isConstant(equalsValue, equals)) {
+						fail(ErrorCode::analysisLimit, "Analyzer::chooseRandomChoice: random chance or equalable isn't supported");
+						return failure;
+					}
+					if (chance == equals) {
+						choice.probabilities[i] = 1;
+						return choice;
+					}
+				}
+				else if (element.chance.type == RandomChoiceChanceType::operand) {
+					Value chanceValue = eval(element.chance.get<Operand>());
+					if (failed() || chanceValue.empty()) {
+						return failure;
+					}
+					if (!isConstant(chanceValue, chances[i])) {
+						fail(ErrorCode::analysisLimit, "Analyzer::chooseRandomChoice: random chance isn't supported");
+						return failure;
+					}
+					freeChance -= chances[i];
+				}
+				else {
+					freeElements++;
+				}
+			}
+			if (freeChance < 0) {
+				return failure;
+			}
+
+			float chanceOnFree = 0;
+			if (freeElements) {
+				chanceOnFree = (float)freeChance / (float)freeElements;
+				if (chanceOnFree < 0.0001 && freeChance > 0) {
+					return failure;
+				}
+			}
+
+			std::vector<int> chosen(randomChoice.choices.size(), 0);
+			int none = 0;
+			for (int random = 1; random <= 100; random++) {
+				float chance = 0;
+				size_t i = 0;
+				for (; i < randomChoice.choices.size(); i++) {
+					if (randomChoice.choices[i].equals.type == RandomChoiceChanceType::operand) {
+						continue;
+					}
+					else if (randomChoice.choices[i].chance.type == RandomChoiceChanceType::operand) {
+						chance += (float)chances[i];
+					}
+					else {
+						chance += chanceOnFree;
+					}
+					if (chance >= (float)random) {
+						break;
+					}
+				}
+				if (i < randomChoice.choices.size()) {
+					chosen[i]++;
+				}
+				else {
+					none++;
+				}
+			}
+			step(100 * randomChoice.choices.size());
+
+			for (size_t i = 0; i < chosen.size(); i++) {
+				choice.probabilities[i] = chosen[i] / 100.0;
+			}
+			if (randomChoice.type == RandomChoiceValueType::checksrow) {
+				choice.none = none / 100.0;
+			}
+			return choice;
+		}
+
+		Value getIterator(int index) {
+			if (index < 0 || size_t(index) >= loopIterators.size()) {
+				return {}; // evaluation fails
+			}
+			return constant(loopIterators[size_t(index)]);
+		}
+	};
+
+	Result<Analysis> tryAnalyze(const Program& program, int numberOfChecks, const Domain* domain = nullptr);
+	Analysis analyze(const Program& program, int numberOfChecks, const Domain* domain = nullptr);
+}
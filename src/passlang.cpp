@@ -1,21 +1,42 @@
 #include "passlang.h"
+#include "specializer.h"
+
+#include <array>
+#include <cstdlib>
 
 
 namespace passlang {
 	namespace Deleter {
-		std::vector<std::function<void()>> deleteFunctions;
+		// Per thread, so separate threads can compile and evaluate expressions at the same time
+		thread_local Pool defaultPool;
+		thread_local Pool* activePool = nullptr;
+
+		void Pool::deleteAll() {
+			for (size_t i = 0; i < allocations.size(); i++) {
+				allocations[i].destroy(allocations[i].object, memoryResource);
+			}
+			allocations.clear();
+		}
 
-		template<typename T>
-		void addDeletable(T* object) {
-			std::function<void()> func = [object]() { delete object; };
-			deleteFunctions.push_back(func);
+		Pool& currentPool() {
+			return activePool ? *activePool : defaultPool;
+		}
+
+		std::pmr::memory_resource* currentResource() {
+			return currentPool().resource();
+		}
+
+		Scope::Scope(Pool& pool) {
+			previous = activePool;
+			activePool = &pool;
+		}
+
+		Scope::~Scope() {
+			activePool = previous;
 		}
 
 		void deleteAll() {
-			for (size_t i = 0; i < deleteFunctions.size(); i++) {
-				deleteFunctions[i]();
-			}
-			deleteFunctions.clear();
+			currentPool().deleteAll();
 		}
 	}
 
@@ -29,92 +50,317 @@ namespace passlang {
 	}
 
 
+    /************* ERRORS *************/
+	void raise(const Error& error) {
+#if PASSLANG_EXCEPTIONS
+		throw std::runtime_error(error.message);
+#else
+		std::cerr << error.message << std::endl;
+		std::abort();
+#endif
+	}
+
+
     /************* TOKENIZER *************/
-    std::vector<Token> tokenize(std::string expression) {
-		std::vector<Token> tokens;
+	enum class CharClass : unsigned char {
+		ignored = 0,
+		single,		// one character token, its type is in the table
+		digit,
+		space,
+		iterator
+	};
 
-		for (size_t ind = 0; ind < expression.length(); ind++) {
-			char i = expression[ind];
-			size_t new_ind;
+	struct CharInfo {
+		CharClass charClass;
+		TokenType tokenType;
+	};
 
-			switch (i) {
-				case '(':
-					tokens.push_back(Token(TokenType::openBracket));
-					break;
-				case ')':
-					tokens.push_back(Token(TokenType::closeBracket));
-					break;
-				case '[':
-					tokens.push_back(Token(TokenType::openSquareBracket));
-					break;
-				case ']':
-					tokens.push_back(Token(TokenType::closeSquareBracket));
-					break;
-				case ';':
-					tokens.push_back(Token(TokenType::semicolon));
-					break;
-				case '+':
-				case '-':
-				case '*':
-				case '/':
-				case '%':
-					tokens.push_back(Token(TokenType::operation, std::string(1, i)));
-					break;
-				case '.':
-					tokens.push_back(Token(TokenType::checkSeparator));
+	static constexpr std::array<CharInfo, 256> makeCharTable() {
+		std::array<CharInfo, 256> table{};
+		for (size_t i = 0; i < table.size(); i++) {
+			table[i] = CharInfo{CharClass::ignored, TokenType::end};
+		}
+		table['('] = CharInfo{CharClass::single, TokenType::openBracket};
+		table[')'] = CharInfo{CharClass::single, TokenType::closeBracket};
+		table['['] = CharInfo{CharClass::single, TokenType::openSquareBracket};
+		table[']'] = CharInfo{CharClass::single, TokenType::closeSquareBracket};
+		table[';'] = CharInfo{CharClass::single, TokenType::semicolon};
+		table['.'] = CharInfo{CharClass::single, TokenType::checkSeparator};
+		table['n'] = CharInfo{CharClass::single, TokenType::numofChecksVariable};
+		for (char i: {'+', '-', '*', '/', '%'}) {
+			table[size_t(i)] = CharInfo{CharClass::single, TokenType::operation};
+		}
+		for (char i = '0'; i <= '9'; i++) {
+			table[size_t(i)] = CharInfo{CharClass::digit, TokenType::operand};
+		}
+		table[' '] = CharInfo{CharClass::space, TokenType::space};
+		table['i'] = CharInfo{CharClass::iterator, TokenType::loopIteratorVariable};
+		return table;
+	}
+	static constexpr std::array<CharInfo, 256> charTable = makeCharTable();
+
+	static CharClass classify(char i) {
+		return charTable[(unsigned char)i].charClass;
+	}
+
+	// Reads digits from ind as int and moves ind after them, false on overflow
+	static bool readNumber(const char* data, size_t length, size_t& ind, int& value) {
+		bool fits = true;
+		value = 0;
+		for (; ind < length && classify(data[ind]) == CharClass::digit; ind++) {
+			int digit = data[ind] - '0';
+			if (value > (INT_MAX - digit) / 10) {
+				fits = false;
+			}
+			else {
+				value = value * 10 + digit;
+			}
+		}
+		return fits;
+	}
+
+	// Runs of spaces are read as one space token, parser skips any number of them the same way
+	Result<std::pmr::vector<Token>> tryTokenize(const std::string& expression) {
+		const char* data = expression.data();
+		size_t length = expression.length();
+
+		std::pmr::vector<Token> tokens(Deleter::currentResource());
+		tokens.reserve(length / 2 + 1);
+		auto push = [&tokens](Token token, size_t offset) {
+			token.offset = offset;
+			tokens.push_back(token);
+		};
+
+		size_t ind = 0;
+		while (ind < length) {
+			size_t start = ind;
+			CharInfo info = charTable[(unsigned char)data[ind]];
+			int number;
+
+			switch (info.charClass) {
+				case CharClass::single:
+					if (info.tokenType == TokenType::operation) {
+						push(Token(TokenType::operation, std::string(1, data[ind])), start);
+					}
+					else {
+						push(Token(info.tokenType), start);
+					}
+					ind++;
 					break;
-				case ' ':
-					tokens.push_back(Token(TokenType::space));
+				case CharClass::space:
+					do {
+						ind++;
+					} while (ind < length && data[ind] == ' ');
+					push(Token(TokenType::space), start);
 					break;
-				case 'n':
-					tokens.push_back(Token(TokenType::numofChecksVariable));
+				case CharClass::digit:
+					if (!readNumber(data, length, ind, number)) {
+						return Error{ErrorCode::invalidNumber, start, "tokenize: number is too big"};
+					}
+					push(Token(TokenType::operand, number), start);
 					break;
-				case 'i':
-					new_ind = ind;
-					do {
-						new_ind++;
-						i = expression[new_ind];
-					} while (new_ind < expression.length() && i >= '0' && i <= '9');
-					if (new_ind - (ind + 1)) {
-						tokens.push_back(Token(TokenType::loopIteratorVariable, std::stoi(expression.substr(ind + 1, new_ind - (ind + 1)))));
-						ind = new_ind - 1;
+				case CharClass::iterator:
+					ind++;
+					if (ind < length && classify(data[ind]) == CharClass::digit) {
+						if (!readNumber(data, length, ind, number)) {
+							return Error{ErrorCode::invalidNumber, start, "tokenize: loop iterator index is too big"};
+						}
+						push(Token(TokenType::loopIteratorVariable, number), start);
 					}
 					break;
 				default:
-					new_ind = ind;
-					while (new_ind < expression.length() && i >= '0' && i <= '9') {
-						new_ind++;
-						i = expression[new_ind];
-					}
-					if (new_ind - ind) {
-						tokens.push_back(Token(TokenType::operand, std::stoi(expression.substr(ind, new_ind - ind))));
-						ind = new_ind - 1;
-					}
+					ind++;
 					break;
 			}
 		}
-		tokens.push_back(Token(TokenType::end));
+		push(Token(TokenType::end), length);
 
 		return tokens;
 	}
+
+	std::pmr::vector<Token> tokenize(const std::string& expression) {
+		return tryTokenize(expression).value();
+	}
+
+
+	/************* PROGRAM *************/
+	Result<Program> tryCompile(const std::string& expression, std::pmr::memory_resource* resource) {
+		std::pmr::polymorphic_allocator<Deleter::Pool> allocator(resource);
+		Program program{std::allocate_shared<Deleter::Pool>(allocator, resource), std::pmr::vector<ChecksRowElement>(resource)};
+		Deleter::Scope scope(*program.pool);
+
+		Result<std::pmr::vector<Token>> tokens = tryTokenize(expression);
+		if (!tokens) {
+			return tokens.error();
+		}
+		Parser parser(std::move(tokens).value());
+		Result<std::pmr::vector<ChecksRowElement>> checks = parser.tryParse();
+		if (!checks) {
+			return checks.error();
+		}
+		program.checks = std::move(checks).value();
+		return program;
+	}
+
+	Program compile(const std::string& expression, std::pmr::memory_resource* resource) {
+		return tryCompile(expression, resource).value();
+	}
+
+	Result<Program> tryCompile(const std::string& expression, const Domain& domain, std::pmr::memory_resource* resource) {
+		Result<Program> program = tryCompile(expression, resource);
+		if (program) {
+			Error error = checkDomain(program.value(), domain);
+			if (error.code != ErrorCode::none) {
+				return error;
+			}
+		}
+		return program;
+	}
+
+	Program compile(const std::string& expression, const Domain& domain, std::pmr::memory_resource* resource) {
+		return tryCompile(expression, domain, resource).value();
+	}
+
+	static bool isNumber(const CheckElement& checkElement, int& number) {
+		if (checkElement.type != CheckElementType::number) {
+			return false;
+		}
+		number = checkElement.get<int>();
+		return true;
+	}
+
+	static bool isNumber(const Operand& operand, int& number) {
+		if (operand.type != OperandType::number) {
+			return false;
+		}
+		number = operand.get<int>();
+		return true;
+	}
+
+	// Whether folded chance of the element is a constant, which makes element with equals decided
+	static bool isNumber(const RandomChoiceChance& chance, Specializer& folder, int& number) {
+		return chance.type == RandomChoiceChanceType::operand && isNumber(folder.specialize(chance.get<Operand>()), number);
+	}
+
+	// Elements of the choice which may be taken: equalable ones whose constant chance and equals differ,
+	// ones with constant chance of zero or less, and free ones when constant chances take all 100 percents are not
+	static std::vector<bool> takenElements(const RandomChoice& randomChoice, Specializer& folder) {
+		std::vector<bool> taken(randomChoice.choices.size(), true);
+		int freeChance = 100;
+		bool constantChances = true;
+		for (size_t i = 0; i < randomChoice.choices.size(); i++) {
+			const RandomChoiceElement& element = randomChoice.choices[i];
+			int chance, equals;
+			bool constantChance = isNumber(element.chance, folder, chance);
+			if (element.equals.type == RandomChoiceChanceType::operand) {
+				taken[i] = !(constantChance && isNumber(element.equals, folder, equals) && chance != equals);
+			}
+			else if (element.chance.type == RandomChoiceChanceType::operand) {
+				taken[i] = !constantChance || chance > 0;
+				constantChances = constantChances && constantChance;
+				freeChance -= constantChance ? chance : 0;
+			}
+		}
+		for (size_t i = 0; i < randomChoice.choices.size(); i++) {
+			if (randomChoice.choices[i].chance.type != RandomChoiceChanceType::operand && constantChances && freeChance <= 0) {
+				taken[i] = false;
+			}
+		}
+		return taken;
+	}
+
+	// Walks checks of rows, loops and random choices of checks, stops at the first error
+	static void checkDomain(const ChecksRowElement& check, const Domain& domain, Specializer& folder, Error& error) {
+		if (error.code != ErrorCode::none) {
+			return;
+		}
+		if (check.type == ChecksRowElementType::loop) {
+			int length;
+			if (isNumber(folder.specialize(check.get<Loop>().length), length) && length <= 0) {
+				return;
+			}
+			for (auto& i: check.get<Loop>().checks) {
+				checkDomain(i, domain, folder, error);
+			}
+			return;
+		}
+		if (check.type == ChecksRowElementType::randomcheckchoice) {
+			const RandomChoice& randomChoice = check.get<RandomChoice>();
+			std::vector<bool> taken = takenElements(randomChoice, folder);
+			for (size_t i = 0; i < randomChoice.choices.size(); i++) {
+				if (taken[i]) {
+					checkDomain(randomChoice.choices[i].value.get<ChecksRowElement>(), domain, folder, error);
+				}
+			}
+			return;
+		}
+		if (check.type != ChecksRowElementType::check) {
+			return;
+		}
+
+		Check value = folder.specialize(check.get<Check>());
+		int world, x, y;
+		bool constantWorld = isNumber(value.world, world);
+		if (constantWorld && !domain.hasWorld(world)) {
+			error = Error{ErrorCode::outOfDomain, value.offset, "checkDomain: world " + std::to_string(world) + " isn't in the domain"};
+			return;
+		}
+		if (isNumber(value.x, x) && (constantWorld ? x < domain.bounds(world).xStart || x > domain.bounds(world).xFinish : !domain.containsX(x))) {
+			error = Error{ErrorCode::outOfDomain, value.offset, "checkDomain: x " + std::to_string(x) + " isn't in bounds of " + (constantWorld ? "world " + std::to_string(world) : "any world")};
+			return;
+		}
+		if (isNumber(value.y, y) && (constantWorld ? y < domain.bounds(world).yStart || y > domain.bounds(world).yFinish : !domain.containsY(y))) {
+			error = Error{ErrorCode::outOfDomain, value.offset, "checkDomain: y " + std::to_string(y) + " isn't in bounds of " + (constantWorld ? "world " + std::to_string(world) : "any world")};
+			return;
+		}
+	}
+
+	Error checkDomain(const Program& program, const Domain& domain) {
+		// Folded nodes are temporary, they are freed with the pool
+		Deleter::Pool pool(program.pool->resource());
+		Deleter::Scope scope(pool);
+		Specializer folder(0);
+		folder.substituteNumberOfChecks = false;
+
+		Error error;
+		for (auto& i: program.checks) {
+			checkDomain(i, domain, folder, error);
+		}
+		return error;
+	}
+
+	Result<std::pmr::vector<C_Check>> tryEvaluate(const Program& program, Interpreter& interpreter) {
+		// Random choices allocate their results, those are freed together after evaluation
+		Deleter::Pool pool(interpreter.resource());
+		Deleter::Scope scope(pool);
+
+		return interpreter.tryRun(program.checks);
+	}
+
+	std::pmr::vector<C_Check> evaluate(const Program& program, Interpreter& interpreter) {
+		return tryEvaluate(program, interpreter).value();
+	}
 }
 
 
 std::function<std::vector<passlang::C_Check>(int, std::string)> initPasslang(std::function<passlang::C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback) {
 	return [checkConstructor, randrangeCallback](int checksNumber, std::string expression) -> std::vector<passlang::C_Check> {
-		auto tokens = passlang::tokenize(expression);
-		passlang::Parser parser(tokens);
-		auto trees = parser.parse();
-
+		passlang::Program program = passlang::compile(expression);
 		passlang::Interpreter interpreter = passlang::Interpreter(checksNumber, checkConstructor, randrangeCallback);
 
-		std::vector<passlang::C_Check> results;
-		for (auto i: trees) {
-			std::vector<passlang::C_Check> checks = interpreter.eval(i);
-			results.insert(results.end(), checks.begin(), checks.end());
-		}
-		passlang::Deleter::deleteAll();
+		std::pmr::vector<passlang::C_Check> checks = passlang::evaluate(program, interpreter);
+		return std::vector<passlang::C_Check>(checks.begin(), checks.end());
+	};
+}
+
+std::function<std::vector<passlang::C_Check>(int, std::string)> initPasslang(const passlang::Domain& domain, std::function<passlang::C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback) {
+	auto sharedDomain = std::make_shared<passlang::Domain>(domain);
+	return [sharedDomain, checkConstructor, randrangeCallback](int checksNumber, std::string expression) -> std::vector<passlang::C_Check> {
+		passlang::Program program = passlang::compile(expression, *sharedDomain);
+		passlang::Interpreter interpreter = passlang::Interpreter(checksNumber, checkConstructor, randrangeCallback);
+		interpreter.domain = sharedDomain.get();
 
-		return results;
+		std::pmr::vector<passlang::C_Check> checks = passlang::evaluate(program, interpreter);
+		return std::vector<passlang::C_Check>(checks.begin(), checks.end());
 	};
 }
@@ -1,16 +1,170 @@
 #pragma once
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <stdexcept>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define PASSLANG_EXCEPTIONS 1
+#else
+#define PASSLANG_EXCEPTIONS 0
+#endif
 
 
 namespace passlang {
+	/************* ERRORS *************/
+	enum class ErrorCode {
+		none = 0,
+		invalidNumber,			// tokenizer: number doesn't fit int
+		unexpectedToken,		// parser
+		unexpectedEnd,
+		invalidNode,			// node of unknown type
+		chanceOverflow,			// interpreter: random choice chances
+		chanceTooSmall,
+		noChoice,
+		unknownIterator,
+		unknownOperator,
+		invalidArithmetic,		// division by zero or overflow in division
+		repeatedCheck,			// uniqueness mode
+		uniqueChecksExhausted,	// every check of the domain is already evaluated
+		redrawLimit,			// check stays repeated after maxRedraws redraws
+		callback,				// checkConstructor or randrangeCallback threw std::exception
+		bufferTooSmall,			// serializer
+		writeFailed,
+		analysisLimit,			// analyzer: over its limits or random chances
+		invalidDomain,			// domain: bad world or bounds
+		outOfDomain				// check isn't in the domain
+	};
+
+	const size_t noOffset = size_t(-1);
+
+	struct Error {
+		ErrorCode code = ErrorCode::none;
+		size_t offset = noOffset; // position in expression, noOffset if unknown
+		std::string message;
+	};
+
+	// Throws std::runtime_error with the message, or prints it and aborts when built without exceptions
+	[[noreturn]] void raise(const Error& error);
+
+	// Value or error, returned by non-throwing try* functions
+	template<typename T>
+	class Result {
+	private:
+		T result{};
+		Error resultError;
+
+	public:
+		Result(T value) : result(std::move(value)) {}
+		Result(Error error) : resultError(std::move(error)) {}
+
+		bool ok() const {
+			return resultError.code == ErrorCode::none;
+		}
+
+		explicit operator bool() const {
+			return ok();
+		}
+
+		const Error& error() const {
+			return resultError;
+		}
+
+		// Raises the error if there is no value
+		T& value() & {
+			if (!ok()) {
+				raise(resultError);
+			}
+			return result;
+		}
+
+		T&& value() && {
+			if (!ok()) {
+				raise(resultError);
+			}
+			return std::move(result);
+		}
+	};
+
+
 	namespace Deleter {
+		// Owns values allocated by TypeHolder and deletes all of them at once. Values and their
+		// containers are allocated from the pool's memory resource
+		class Pool {
+		private:
+			struct Allocation {
+				void* object;
+				void (*destroy)(void* object, std::pmr::memory_resource* resource);
+			};
+
+			std::pmr::memory_resource* memoryResource;
+			std::pmr::vector<Allocation> allocations;
+
+			template<typename T>
+			static void destroy(void* object, std::pmr::memory_resource* resource) {
+				static_cast<T*>(object)->~T();
+				resource->deallocate(object, sizeof(T), alignof(T));
+			}
+
+		public:
+			Pool(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : memoryResource(resource), allocations(resource) {}
+			Pool(const Pool&) = delete;
+			Pool& operator=(const Pool&) = delete;
+
+			~Pool() {
+				deleteAll();
+			}
+
+			// Copies value into the pool, uses-allocator construction gives the resource to its pmr containers
+			template<typename T>
+			T* create(const T& value) {
+				std::pmr::polymorphic_allocator<T> allocator(memoryResource);
+				T* object = allocator.allocate(1);
+				allocator.construct(object, value);
+				allocations.push_back(Allocation{object, &destroy<T>});
+				return object;
+			}
+
+			std::pmr::memory_resource* resource() const {
+				return memoryResource;
+			}
+
+			void deleteAll();
+		};
+
+		// Pool of the innermost active Scope in this thread, or thread's own default pool
+		Pool& currentPool();
+
+		// Memory resource of the current pool, containers built for its nodes should use it
+		std::pmr::memory_resource* currentResource();
+
+		// Makes given pool current in this thread for the lifetime of the scope
+		class Scope {
+		private:
+			Pool* previous;
+
+		public:
+			Scope(Pool& pool);
+			~Scope();
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		};
+
 		template<typename T>
-		void addDeletable(T* object);
+		T* create(const T& value) {
+			return currentPool().create(value);
+		}
+
 		void deleteAll();
 	}
 
@@ -22,20 +176,23 @@ namespace passlang {
 	public:
 		T type;
 
+		TypeHolder() {
+			this->type = T();
+		}
+
 		TypeHolder(T type) {
 			this->type = type;
 		}
 
 		template<typename T1>
-		TypeHolder(T type, T1 value) {
+		TypeHolder(T type, const T1& value) {
 			this->type = type;
-			T1* t_ptr = new T1(value);
-			ptr = t_ptr;
-			Deleter::addDeletable(t_ptr);
+			ptr = Deleter::create(value);
 		}
 
+		// Reference to the value in its pool, valid while the pool keeps it
 		template<typename T1>
-		T1 get() {
+		T1& get() const {
 			return *((T1*)ptr);
 		}
 	};
@@ -56,8 +213,14 @@ namespace passlang {
 		loopIteratorVariable,
 		end
 	};
-	typedef TypeHolder<TokenType> Token;
-	std::vector<Token> tokenize(std::string expression);
+	struct Token : TypeHolder<TokenType> {
+		using TypeHolder<TokenType>::TypeHolder;
+
+		size_t offset = 0; // position in expression
+	};
+	// Tokens are allocated from Deleter::currentResource()
+	Result<std::pmr::vector<Token>> tryTokenize(const std::string& expression);
+	std::pmr::vector<Token> tokenize(const std::string& expression);
 
 
 	/************* PARSER *************/
@@ -110,11 +273,20 @@ namespace passlang {
 	struct Check {
 		CheckElement world;
 		CheckElement x, y;
+		size_t offset = noOffset; // position of the check in expression
 	};
 
+	// Nodes with containers are allocator-aware, so Deleter::Pool copies them into its resource
 	struct Loop {
+		using allocator_type = std::pmr::polymorphic_allocator<ChecksRowElement>;
+
 		Operand length;
-		std::vector<ChecksRowElement> checks;
+		std::pmr::vector<ChecksRowElement> checks;
+		size_t offset = noOffset; // position of the loop in expression
+
+		Loop() = default;
+		Loop(Operand length, std::pmr::vector<ChecksRowElement> checks, size_t offset = noOffset) : length(length), checks(std::move(checks)), offset(offset) {}
+		Loop(const Loop& loop, const allocator_type& allocator) : length(loop.length), checks(loop.checks, allocator), offset(loop.offset) {}
 	};
 
 	struct RandomRange {
@@ -128,32 +300,88 @@ namespace passlang {
 		RandomChoiceChance equals;
 	};
 	struct RandomChoice {
-		RandomChoiceValueType type;
-		std::vector<RandomChoiceElement> choices;
+		using allocator_type = std::pmr::polymorphic_allocator<RandomChoiceElement>;
+
+		RandomChoiceValueType type = RandomChoiceValueType::operand;
+		std::pmr::vector<RandomChoiceElement> choices;
+		size_t offset = noOffset; // position of "[" in expression
+
+		RandomChoice() = default;
+		RandomChoice(RandomChoiceValueType type, std::pmr::vector<RandomChoiceElement> choices, size_t offset = noOffset) : type(type), choices(std::move(choices)), offset(offset) {}
+		RandomChoice(const RandomChoice& randomChoice, const allocator_type& allocator) : type(randomChoice.type), choices(randomChoice.choices, allocator), offset(randomChoice.offset) {}
 	};
 
 
+	// Builds operations of expression into nodes while operands come: runs of "*" and "/" are
+	// calculated first, then "+", "-" and "%" from left to right. makeNode(first, operation, second)
+	// returns operand of one operation. Shared by Parser and Validator, so both see the same order
+	template<typename T, typename MakeNode>
+	class ExpressionBuilder {
+	private:
+		T node;
+		T term;
+		std::string termOperation = "+";
+		MakeNode makeNode;
+
+	public:
+		ExpressionBuilder(T op_null, T first, MakeNode makeNode) : node(op_null), term(first), makeNode(makeNode) {}
+
+		void add(const std::string& operation, T operand) {
+			if (operation == "*" || operation == "/") {
+				term = makeNode(term, operation, operand);
+			}
+			else {
+				node = makeNode(node, termOperation, term);
+				termOperation = operation;
+				term = operand;
+			}
+		}
+
+		T finish() {
+			return makeNode(node, termOperation, term);
+		}
+	};
+
+
+	// Doesn't throw: the first error is kept in error, after it parse* methods return empty nodes
 	class Parser {
 	private:
 		size_t index = 0;
+		size_t lastIndex = 0; // last peeked or popped token, errors point to it
+
+		void fail(ErrorCode code, std::string message) {
+			if (failed()) {
+				return;
+			}
+			error.code = code;
+			error.offset = tokens.size() ? tokens[std::min(lastIndex, tokens.size() - 1)].offset : 0;
+			error.message = message;
+		}
 
 	public:
-		std::vector<Token> tokens;
+		std::pmr::vector<Token> tokens;
+		Error error;
+
+		Parser(std::pmr::vector<Token> tokens) : tokens(std::move(tokens)) {}
 
-		Parser(std::vector<Token> tokens) {
-			this->tokens = tokens;
+		bool failed() const {
+			return error.code != ErrorCode::none;
 		}
 
 		Token peekToken() {
+			lastIndex = index;
 			if (index >= tokens.size()) {
-				throw std::runtime_error("Parser::peekToken: out of bounds");
+				fail(ErrorCode::unexpectedEnd, "Parser::peekToken: out of bounds");
+				return Token(TokenType::end);
 			}
 			return tokens[index];
 		}
 
 		Token popToken() {
+			lastIndex = index;
 			if (index >= tokens.size()) {
-				throw std::runtime_error("Parser::popToken: out of bounds");
+				fail(ErrorCode::unexpectedEnd, "Parser::popToken: out of bounds");
+				return Token(TokenType::end);
 			}
 			return tokens[index++];
 		}
@@ -164,13 +392,22 @@ namespace passlang {
 			}
 		}
 
-		auto parse() {
-			return parseChecksRow();
+		// Nodes are allocated in the current Deleter pool
+		Result<std::pmr::vector<ChecksRowElement>> tryParse() {
+			std::pmr::vector<ChecksRowElement> checks = parseChecksRow();
+			if (failed()) {
+				return error;
+			}
+			return checks;
 		}
 
-		std::vector<ChecksRowElement> parseChecksRow() {
-			std::vector<ChecksRowElement> checks;
-			while (peekToken().type != TokenType::end && peekToken().type != TokenType::closeBracket) {
+		std::pmr::vector<ChecksRowElement> parse() {
+			return tryParse().value();
+		}
+
+		std::pmr::vector<ChecksRowElement> parseChecksRow() {
+			std::pmr::vector<ChecksRowElement> checks(Deleter::currentResource());
+			while (!failed() && peekToken().type != TokenType::end && peekToken().type != TokenType::closeBracket) {
 				checks.push_back(parseCheck());
 				skipSpace();
 			}
@@ -180,12 +417,16 @@ namespace passlang {
 
 		ChecksRowElement parseCheck() {
 			skipSpace();
+			size_t offset = peekToken().offset;
 
 			CheckElement rand = CheckElement(CheckElementType::random);
 
 			if (peekToken().type == TokenType::openSquareBracket) {
 				size_t old_index = index;
 				RandomChoice randomCheckChoice = parseRandomChoice(true);
+				if (failed()) {
+					return {};
+				}
 				if (peekToken().type == TokenType::checkSeparator) {
 					index = old_index;
 				}
@@ -195,33 +436,45 @@ namespace passlang {
 			}
 
 			CheckElement world = parseCheckElement();
+			if (failed()) {
+				return {};
+			}
 			if (peekToken().type != TokenType::checkSeparator) {
 				if (peekToken().type == TokenType::openBracket) {
-					return parseLoop(world);
+					return parseLoop(world, offset);
 				}
 				else {
-					return ChecksRowElement(ChecksRowElementType::check, Check{world, rand, rand});
+					return ChecksRowElement(ChecksRowElementType::check, Check{world, rand, rand, offset});
 				}
 			}
 			popToken();
 
 			CheckElement x = parseCheckElement();
+			if (failed()) {
+				return {};
+			}
 			if (popToken().type != TokenType::checkSeparator) {
-				throw std::runtime_error("Parser::parseCheck: can't find \".\" after x coordinate");
+				fail(ErrorCode::unexpectedToken, "Parser::parseCheck: can't find \".\" after x coordinate");
+				return {};
 			}
 
 			CheckElement y = parseCheckElement();
+			if (failed()) {
+				return {};
+			}
 
-			return ChecksRowElement(ChecksRowElementType::check, Check{world, x, y});
+			return ChecksRowElement(ChecksRowElementType::check, Check{world, x, y, offset});
 		}
 
 		RandomChoice parseRandomChoice(bool is_checks=false) {
+			size_t offset = peekToken().offset;
 			if (popToken().type != TokenType::openSquareBracket) {
-				throw std::runtime_error("Parser::parseRandomChoice: can't find \"[\" at the start");
+				fail(ErrorCode::unexpectedToken, "Parser::parseRandomChoice: can't find \"[\" at the start");
+				return {};
 			}
 			skipSpace();
 
-			RandomChoice randomChoice;
+			RandomChoice randomChoice(RandomChoiceValueType::operand, std::pmr::vector<RandomChoiceElement>(Deleter::currentResource()), offset);
 			if (is_checks) {
 				randomChoice.type = RandomChoiceValueType::checksrow;
 			}
@@ -229,7 +482,7 @@ namespace passlang {
 				randomChoice.type = RandomChoiceValueType::operand;
 			}
 
-			while (peekToken().type != TokenType::closeSquareBracket) {
+			while (!failed() && peekToken().type != TokenType::closeSquareBracket) {
 				randomChoice.choices.push_back(parseRandomChoiceElement(is_checks));
 				skipSpace();
 			}
@@ -248,35 +501,50 @@ namespace passlang {
 			else {
 				value = RandomChoiceValue(RandomChoiceValueType::operand, parseOperand());
 			}
+			if (failed()) {
+				return {};
+			}
 
 			RandomChoiceChance chance = RandomChoiceChance(RandomChoiceChanceType::none);
 			RandomChoiceChance equals = RandomChoiceChance(RandomChoiceChanceType::none);
 			if (peekToken().type == TokenType::semicolon) {
 				popToken();
 				if (peekToken().type == TokenType::space) {
-					throw std::runtime_error("Parser::parseRandomChoiceElement: chance must be set after semicolon without spaces");
+					fail(ErrorCode::unexpectedToken, "Parser::parseRandomChoiceElement: chance must be set after semicolon without spaces");
+					return {};
 				}
 				chance = RandomChoiceChance(RandomChoiceChanceType::operand, parseOperand());
+				if (failed()) {
+					return {};
+				}
 
 				if (peekToken().type == TokenType::semicolon) {
 					popToken();
 					if (peekToken().type == TokenType::space) {
-						throw std::runtime_error("Parser::parseRandomChoiceElement: equalable must be set after semicolon without spaces");
+						fail(ErrorCode::unexpectedToken, "Parser::parseRandomChoiceElement: equalable must be set after semicolon without spaces");
+						return {};
 					}
 					equals = RandomChoiceChance(RandomChoiceChanceType::operand, parseOperand());
+					if (failed()) {
+						return {};
+					}
 				}
 			}
 
 			return RandomChoiceElement{value, chance, equals};
 		}
 
-		ChecksRowElement parseLoop(CheckElement length) {
+		ChecksRowElement parseLoop(CheckElement length, size_t offset) {
 			Operand loopLength = CheckElement2Operand(length);
 
 			if (popToken().type != TokenType::openBracket) {
-				throw std::runtime_error("Parser::parseLoop: can't find \"(\" at the start");
+				fail(ErrorCode::unexpectedToken, "Parser::parseLoop: can't find \"(\" at the start");
+				return {};
+			}
+			Loop loop{loopLength, parseChecksRow(), offset};
+			if (failed()) {
+				return {};
 			}
-			Loop loop{loopLength, parseChecksRow()};
 			return ChecksRowElement(ChecksRowElementType::loop, loop);
 		}
 
@@ -306,11 +574,19 @@ namespace passlang {
 				return checkElement;
 			}
 			else {
-				throw std::runtime_error("Parser::parseCheckElement: can't use given Token");
+				fail(ErrorCode::unexpectedToken, "Parser::parseCheckElement: can't use given Token");
+				return {};
+			}
+			if (failed()) {
+				return {};
 			}
 
 			if (peekToken().type == TokenType::operation && peekToken().get<std::string>() == "-") {
-				return CheckElement(CheckElementType::randomrange, parseRandomRange(CheckElement2Operand(checkElement)));
+				RandomRange randomRange = parseRandomRange(CheckElement2Operand(checkElement));
+				if (failed()) {
+					return {};
+				}
+				return CheckElement(CheckElementType::randomrange, randomRange);
 			}
 			return checkElement;
 		}
@@ -323,7 +599,7 @@ namespace passlang {
 				return Operand(OperandType::expression, checkElement.get<ExpressionNode>());
 			}
 			else if (checkElement.type == CheckElementType::randomrange) {
-				return Operand(OperandType::randomchoice, checkElement.get<RandomRange>());
+				return Operand(OperandType::randomrange, checkElement.get<RandomRange>());
 			}
 			else if (checkElement.type == CheckElementType::randomchoice) {
 				return Operand(OperandType::randomchoice, checkElement.get<RandomChoice>());
@@ -334,16 +610,21 @@ namespace passlang {
 			else if (checkElement.type == CheckElementType::loopiterator) {
 				return Operand(OperandType::loopiterator, checkElement.get<int>());
 			}
-			throw std::runtime_error("Parser::CheckElement2Operand: can't use given CheckElement");
+			fail(ErrorCode::invalidNode, "Parser::CheckElement2Operand: can't use given CheckElement");
+			return {};
 		}
 
 		RandomRange parseRandomRange(Operand start) {
 			if (peekToken().type != TokenType::operand && peekToken().get<std::string>() != "-") {
-				throw std::runtime_error("Parser::parseRandomRange: can't find \"-\" after first operand");
+				fail(ErrorCode::unexpectedToken, "Parser::parseRandomRange: can't find \"-\" after first operand");
+				return {};
 			}
 			popToken();
 
 			Operand finish = parseOperand(true);
+			if (failed()) {
+				return {};
+			}
 
 			return RandomRange{start, finish};
 		};
@@ -352,85 +633,37 @@ namespace passlang {
 			skipSpace();
 			Token openBracket = popToken();
 			if (openBracket.type != TokenType::openBracket) {
-				throw std::runtime_error("Parser::parseExpression: can't find \"(\" at the start");
+				fail(ErrorCode::unexpectedToken, "Parser::parseExpression: can't find \"(\" at the start");
+				return {};
 			}
 
-			std::vector<Operand> operands = {parseOperand()};
-			std::vector<std::string> operations;
+			Operand op_null = Operand(OperandType::number, 0);
+			Operand first = parseOperand();
+			if (failed()) {
+				return {};
+			}
+			ExpressionBuilder builder(op_null, first, [](Operand firstOperand, std::string operation, Operand secondOperand) {
+				return Operand(OperandType::expression, ExpressionNode{firstOperand, operation, secondOperand});
+			});
 
 			do {
 				skipSpace();
 				Token operation = popToken();
 				if (operation.type != TokenType::operation) {
-					throw std::runtime_error("Parser::parseExpression: can't find operation after operand");
+					fail(ErrorCode::unexpectedToken, "Parser::parseExpression: can't find operation after operand");
+					return {};
 				}
-				operations.push_back(operation.get<std::string>());
 
-				operands.push_back(parseOperand());
+				Operand operand = parseOperand();
+				if (failed()) {
+					return {};
+				}
+				builder.add(operation.get<std::string>(), operand);
 				skipSpace();
 			} while (peekToken().type != TokenType::closeBracket);
 			popToken(); // closeBracket
 
-			// Builds list of operations and operands into nodes, sorts them by math rules
-			std::vector<std::string> plus_operations, minus_operations;
-			std::vector<Operand> plus_operands, minus_operands;
-
-			for (int i = 0; i < operations.size(); i++) {
-				int j = i;
-				while (j < operations.size() && (operations[j] == "*" || operations[j] == "/")) {
-					j++;
-				}
-
-				if (j > i) {
-					if (i == 0 || operations[i - 1] == "+") {
-						plus_operations.insert(plus_operations.end(), operations.begin() + i, operations.begin() + j);
-						plus_operands.insert(plus_operands.end(), operands.begin() + i, operands.begin() + j + 1);
-					}
-					else if (operations[i - 1] == "-") {
-						minus_operations.insert(minus_operations.end(), operations.begin() + i, operations.begin() + j);
-						minus_operands.insert(minus_operands.end(), operands.begin() + i, operands.begin() + j + 1);
-					}
-					operations.erase(operations.begin() + i - (i != 0), operations.begin() + j);
-					operands.erase(operands.begin() + i, operands.begin() + j + 1);
-					i -= 1;
-				}
-			}
-
-			Operand op_null = Operand(OperandType::number, 0);
-
-			ExpressionNode node{op_null, "+", op_null};
-			if (operations.size() == 0) {
-				Operand op = op_null;
-				if (operands.size()) {
-					op = operands[0];
-				}
-				node = ExpressionNode{op_null, "+", op};
-			}
-			else {
-				node = ExpressionNode{operands[0], operations[0], operands[1]};
-				for (size_t i = 1; i < operations.size(); i++) {
-					node = ExpressionNode{Operand(OperandType::expression, node), operations[i], operands[i + 1]};
-				}
-			}
-
-			ExpressionNode wrapper = ExpressionNode{op_null, "+", op_null};
-			if (minus_operations.size()) {
-				ExpressionNode minus_node = ExpressionNode{minus_operands[0], minus_operations[0], minus_operands[1]};
-				for (size_t i = 1; i < minus_operations.size(); i++) {
-					minus_node = ExpressionNode{Operand(OperandType::expression, minus_node), minus_operations[i], minus_operands[i + 1]};
-				}
-				wrapper = ExpressionNode{Operand(OperandType::expression, wrapper), "-", Operand(OperandType::expression, minus_node)};
-			}
-			if (plus_operations.size()) {
-				ExpressionNode plus_node = ExpressionNode{plus_operands[0], plus_operations[0], plus_operands[1]};
-				for (size_t i = 1; i < plus_operations.size(); i++) {
-					plus_node = ExpressionNode{Operand(OperandType::expression, plus_node), plus_operations[i], plus_operands[i + 1]};
-				}
-				wrapper = ExpressionNode{Operand(OperandType::expression, wrapper), "+", Operand(OperandType::expression, plus_node)};
-			}
-			node = ExpressionNode{Operand(OperandType::expression, wrapper), "+", Operand(OperandType::expression, node)};
-
-			return node;
+			return builder.finish().get<ExpressionNode>();
 		}
 
 		Operand parseOperand(bool is_finish=false) {
@@ -455,20 +688,163 @@ namespace passlang {
 				operand = Operand(OperandType::loopiterator, popToken().get<int>());
 			}
 			else {
-				throw std::runtime_error("Parser::parseOperand: can't use given Token");
+				fail(ErrorCode::unexpectedToken, "Parser::parseOperand: can't use given Token");
+				return {};
+			}
+			if (failed()) {
+				return {};
 			}
 
 			if (peekToken().type == TokenType::operation && peekToken().get<std::string>() == "-") {
 				if (is_finish) {
-					throw std::runtime_error("Parser::parseOperand: randrange takes only 2 points, but second \"-\" was found");
+					fail(ErrorCode::unexpectedToken, "Parser::parseOperand: randrange takes only 2 points, but second \"-\" was found");
+					return {};
 				}
-				return Operand(OperandType::randomrange, parseRandomRange(operand));
+				RandomRange randomRange = parseRandomRange(operand);
+				if (failed()) {
+					return {};
+				}
+				return Operand(OperandType::randomrange, randomRange);
 			}
 			return operand;
 		}
 	};
 
 
+	/************* DOMAIN *************/
+	// Worlds 0..worlds-1 with coordinate bounds of each world (both ends included) and worlds which are
+	// excluded. Interpreter draws random placeholders from it, compile checks constant coordinates against it.
+	// Excluded worlds are never drawn, but checks naming them are valid and contain() only allowed ones.
+	// Raises ErrorCode::invalidDomain on bad world or bounds, try* methods return it instead
+	class Domain {
+	public:
+		struct Bounds {
+			int xStart, xFinish;
+			int yStart, yFinish;
+		};
+
+	private:
+		std::vector<Bounds> worldBounds;
+		std::vector<bool> excluded;
+		std::vector<int> allowed; // table of allowed worlds, placeholder of world is a random index in it
+
+		Error checkWorld(int world, const std::string& method) const {
+			if (world < 0 || world >= worlds()) {
+				return Error{ErrorCode::invalidDomain, noOffset, "Domain::" + method + ": world " + std::to_string(world) + " isn't in 0-" + std::to_string(worlds() - 1)};
+			}
+			return Error();
+		}
+
+	public:
+		// Every world has the same bounds start..finish for x and y
+		Domain(int worlds, int start, int finish) {
+			if (worlds <= 0) {
+				raise(Error{ErrorCode::invalidDomain, noOffset, "Domain: number of worlds must be positive"});
+			}
+			if (start > finish) {
+				raise(Error{ErrorCode::invalidDomain, noOffset, "Domain: start of bounds is greater than finish"});
+			}
+			worldBounds.assign(size_t(worlds), Bounds{start, finish, start, finish});
+			excluded.assign(size_t(worlds), false);
+			for (int i = 0; i < worlds; i++) {
+				allowed.push_back(i);
+			}
+		}
+
+		// The last allowed world can't be excluded, so placeholders always have a world to take.
+		// Returns false if the world was already excluded
+		Result<bool> tryExclude(int world) {
+			Error error = checkWorld(world, "exclude");
+			if (error.code != ErrorCode::none) {
+				return error;
+			}
+			if (excluded[size_t(world)]) {
+				return false;
+			}
+			if (allowed.size() == 1) {
+				return Error{ErrorCode::invalidDomain, noOffset, "Domain::exclude: can't exclude the last allowed world " + std::to_string(world)};
+			}
+			excluded[size_t(world)] = true;
+			allowed.erase(std::find(allowed.begin(), allowed.end(), world));
+			return true;
+		}
+
+		Result<bool> trySetBounds(int world, int xStart, int xFinish, int yStart, int yFinish) {
+			Error error = checkWorld(world, "setBounds");
+			if (error.code != ErrorCode::none) {
+				return error;
+			}
+			if (xStart > xFinish || yStart > yFinish) {
+				return Error{ErrorCode::invalidDomain, noOffset, "Domain::setBounds: start of bounds is greater than finish"};
+			}
+			worldBounds[size_t(world)] = Bounds{xStart, xFinish, yStart, yFinish};
+			return true;
+		}
+
+		void exclude(int world) {
+			tryExclude(world).value();
+		}
+
+		void setBounds(int world, int xStart, int xFinish, int yStart, int yFinish) {
+			trySetBounds(world, xStart, xFinish, yStart, yFinish).value();
+		}
+
+		int worlds() const {
+			return int(worldBounds.size());
+		}
+
+		// Whether checks may name the world, excluded worlds included
+		bool hasWorld(int world) const {
+			return world >= 0 && world < worlds();
+		}
+
+		bool contains(int world) const {
+			return hasWorld(world) && !excluded[size_t(world)];
+		}
+
+		bool contains(int world, int x, int y) const {
+			return contains(world) && x >= bounds(world).xStart && x <= bounds(world).xFinish && y >= bounds(world).yStart && y <= bounds(world).yFinish;
+		}
+
+		// Number of different checks in the domain
+		uint64_t size() const {
+			uint64_t sum = 0;
+			for (int i: allowed) {
+				sum += uint64_t((long long)bounds(i).xFinish - bounds(i).xStart + 1) * uint64_t((long long)bounds(i).yFinish - bounds(i).yStart + 1);
+			}
+			return sum;
+		}
+
+		// World must be in 0..worlds-1
+		const Bounds& bounds(int world) const {
+			return worldBounds[size_t(world)];
+		}
+
+		const std::vector<int>& allowedWorlds() const {
+			return allowed;
+		}
+
+		// Whether some world, excluded ones included, has x or y in its bounds
+		bool containsX(int x) const {
+			for (auto& i: worldBounds) {
+				if (x >= i.xStart && x <= i.xFinish) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool containsY(int y) const {
+			for (auto& i: worldBounds) {
+				if (y >= i.yStart && y <= i.yFinish) {
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+
 	/************* INTERPRETER *************/
 	const int randomPlaceholder = -1;
 
@@ -478,6 +854,68 @@ namespace passlang {
 	};
 	extern std::ostream& operator<<(std::ostream& stream, C_Check check);
 
+	// Open addressing set of checks, used to keep generated checks unique
+	class CheckSet {
+	private:
+		std::pmr::vector<C_Check> slots;
+		std::pmr::vector<bool> used;
+		size_t count = 0;
+
+		static size_t hash(C_Check check) {
+			uint64_t value = uint64_t(uint32_t(check.world)) * 0x9e3779b97f4a7c15ULL;
+			value ^= uint64_t(uint32_t(check.x)) + 0xbf58476d1ce4e5b9ULL + (value << 6) + (value >> 2);
+			value ^= uint64_t(uint32_t(check.y)) + 0x94d049bb133111ebULL + (value << 6) + (value >> 2);
+			value ^= value >> 31;
+			return size_t(value * 0xd6e8feb86659fd93ULL);
+		}
+
+		bool insertNew(C_Check check) {
+			size_t mask = slots.size() - 1;
+			for (size_t i = hash(check) & mask;; i = (i + 1) & mask) {
+				if (!used[i]) {
+					used[i] = true;
+					slots[i] = check;
+					count++;
+					return true;
+				}
+				if (slots[i].world == check.world && slots[i].x == check.x && slots[i].y == check.y) {
+					return false;
+				}
+			}
+		}
+
+	public:
+		CheckSet(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : slots(resource), used(resource) {}
+
+		// Returns false if the check is already in the set
+		bool insert(C_Check check) {
+			if ((count + 1) * 2 > slots.size()) {
+				size_t capacity = slots.size() ? slots.size() * 2 : 64;
+				std::pmr::vector<C_Check> previousSlots(std::move(slots));
+				std::pmr::vector<bool> previousUsed(std::move(used));
+				slots.assign(capacity, C_Check());
+				used.assign(capacity, false);
+				count = 0;
+				for (size_t i = 0; i < previousSlots.size(); i++) {
+					if (previousUsed[i]) {
+						insertNew(previousSlots[i]);
+					}
+				}
+			}
+			return insertNew(check);
+		}
+
+		size_t size() const {
+			return count;
+		}
+
+		void clear() {
+			slots.clear();
+			used.clear();
+			count = 0;
+		}
+	};
+
 	enum class RandomChoiceResultType {
 		number = 0,
 		vector
@@ -485,45 +923,200 @@ namespace passlang {
 	typedef TypeHolder<RandomChoiceResultType> RandomChoiceResult;
 
 
+	// Doesn't throw: the first error is kept in error, after it eval methods return empty values.
+	// std::exception thrown by callbacks is kept as ErrorCode::callback error
 	class Interpreter {
 	private:
-		std::vector<int> loopIterators;
+		std::pmr::memory_resource* memoryResource;
+		std::pmr::vector<int> loopIterators;
 		std::function<C_Check(int, int, int)> checkConstructor;
 		std::function<int(int, int)> randrangeCallback;
+		CheckSet evaluatedChecks;
+		uint64_t domainChecks = 0; // evaluated checks which are in the domain
+
+		size_t currentOffset = noOffset; // innermost check, loop or random choice being evaluated
+
+		// Points the error to the evaluated node if no offset is given
+		void fail(ErrorCode code, std::string message, size_t offset = noOffset) {
+			if (!failed()) {
+				error = Error{code, offset != noOffset ? offset : currentOffset, message};
+			}
+		}
+
+		// Makes errors point to the node for the lifetime of the scope, if the node has an offset
+		class OffsetScope {
+		private:
+			size_t& offset;
+			size_t previous;
+
+		public:
+			OffsetScope(size_t& offset, size_t node) : offset(offset), previous(offset) {
+				if (node != noOffset) {
+					offset = node;
+				}
+			}
+
+			~OffsetScope() {
+				offset = previous;
+			}
+
+			OffsetScope(const OffsetScope&) = delete;
+			OffsetScope& operator=(const OffsetScope&) = delete;
+		};
+
+		int callRandrange(int start, int finish) {
+#if PASSLANG_EXCEPTIONS
+			try {
+				return randrangeCallback(start, finish);
+			}
+			catch (const std::exception& exception) {
+				fail(ErrorCode::callback, exception.what());
+				return 0;
+			}
+#else
+			return randrangeCallback(start, finish);
+#endif
+		}
+
+		// Percent drawn by random choices, std::rand() % 100 + 1 unless choiceCallback is set
+		int callChoice() {
+			if (!choiceCallback) {
+				return (std::rand() % 100) + 1;
+			}
+#if PASSLANG_EXCEPTIONS
+			try {
+				return choiceCallback();
+			}
+			catch (const std::exception& exception) {
+				fail(ErrorCode::callback, exception.what());
+				return 0;
+			}
+#else
+			return choiceCallback();
+#endif
+		}
+
+		C_Check callCheckConstructor(int world, int x, int y) {
+#if PASSLANG_EXCEPTIONS
+			try {
+				return checkConstructor(world, x, y);
+			}
+			catch (const std::exception& exception) {
+				fail(ErrorCode::callback, exception.what());
+				return {};
+			}
+#else
+			return checkConstructor(world, x, y);
+#endif
+		}
 
 	public:
+		static const size_t defaultMaxRedraws = 1000;
+
 		int numberOfChecks;
 
-		Interpreter(int numberOfChecks, std::function<C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback) {
+		// Uniqueness mode: a check equal to already evaluated one is evaluated again, so its random
+		// placeholders and random ranges are redrawn. Checks without random parts (also ones taken from
+		// random choice of checks) can't be redrawn and fail on collision, as does a check which stays
+		// colliding after maxRedraws attempts (ErrorCode::redrawLimit). With domain a collision fails at once
+		// with ErrorCode::uniqueChecksExhausted when every check of the domain is already evaluated. Checks are
+		// unique within one run, call resetUniqueChecks after changing the domain when calling eval directly.
+		// redraws counts repeated evaluations of the last run
+		bool uniqueChecks = false;
+		size_t maxRedraws = defaultMaxRedraws;
+		size_t redraws = 0;
+
+		// Random placeholders are drawn from the domain before checkConstructor is called, and checks
+		// out of it fail with ErrorCode::outOfDomain. Not owned, without it placeholders go to checkConstructor
+		const Domain* domain = nullptr;
+
+		// Draws 1..100 for random choices instead of std::rand(), so all randomness can come from one source
+		std::function<int()> choiceCallback;
+
+		Error error;
+
+		// Evaluated checks, loop iterators and results of random choices are allocated from resource
+		Interpreter(int numberOfChecks, std::function<C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: memoryResource(resource), loopIterators(resource), evaluatedChecks(resource) {
 			this->numberOfChecks = numberOfChecks;
 			this->checkConstructor = checkConstructor;
 			this->randrangeCallback = randrangeCallback;
 		}
 
+		bool failed() const {
+			return error.code != ErrorCode::none;
+		}
+
+		std::pmr::memory_resource* resource() const {
+			return memoryResource;
+		}
+
+		// Evaluates row of checks from the start (clears previous error, loop iterators and evaluated checks
+		// of uniqueness mode, so checks are unique within one run)
+		Result<std::pmr::vector<C_Check>> tryRun(const std::pmr::vector<ChecksRowElement>& checks) {
+			error = Error();
+			loopIterators.clear();
+			currentOffset = noOffset;
+			resetUniqueChecks();
+
+			std::pmr::vector<C_Check> results(memoryResource);
+			for (auto i: checks) {
+				std::pmr::vector<C_Check> row = eval(i);
+				if (failed()) {
+					return error;
+				}
+				results.insert(results.end(), row.begin(), row.end());
+			}
+			return results;
+		}
+
+		std::pmr::vector<C_Check> run(const std::pmr::vector<ChecksRowElement>& checks) {
+			return tryRun(checks).value();
+		}
 
-		std::vector<C_Check> eval(ChecksRowElement check) {
+		std::pmr::vector<C_Check> eval(ChecksRowElement check) {
 			if (check.type == ChecksRowElementType::check) {
-				return {eval(check.get<Check>())};
+				C_Check c_check = eval(check.get<Check>());
+				if (failed()) {
+					return {};
+				}
+				std::pmr::vector<C_Check> checks(memoryResource);
+				checks.push_back(c_check);
+				return checks;
 			}
 			else if (check.type == ChecksRowElementType::loop) {
 				return eval(check.get<Loop>());
 			}
 			else if (check.type == ChecksRowElementType::randomcheckchoice) {
-				return eval(check.get<RandomChoice>()).get<std::vector<C_Check>>();
+				RandomChoiceResult result = eval(check.get<RandomChoice>());
+				if (failed()) {
+					return {};
+				}
+				return std::move(result.get<std::pmr::vector<C_Check>>()); // result is a temporary of this evaluation
 			}
 
-			throw std::runtime_error("Interpreter::evalChecksRowElement: can't use given ChecksRowElement");
+			fail(ErrorCode::invalidNode, "Interpreter::evalChecksRowElement: can't use given ChecksRowElement");
+			return {};
 		}
 
-		RandomChoiceResult eval(RandomChoice randomChoice) {
-			float random = (rand() % 100) + 1;
+		RandomChoiceResult eval(const RandomChoice& randomChoice) {
+			OffsetScope scope(currentOffset, randomChoice.offset);
+			float random = float(callChoice());
 			float chanceOnFree = 0;
 			int freeChance = 100;
 			int freeElements = 0;
+			if (failed()) {
+				return {};
+			}
 
 			for (int i = 0; i < randomChoice.choices.size(); i++) {
 				if (randomChoice.choices[i].equals.type == RandomChoiceChanceType::operand) {
-					if (eval(randomChoice.choices[i].chance.get<Operand>()) == eval(randomChoice.choices[i].equals.get<Operand>())) {
+					int chance = eval(randomChoice.choices[i].chance.get<Operand>());
+					int equals = eval(randomChoice.choices[i].equals.get<Operand>());
+					if (failed()) {
+						return {};
+					}
+					if (chance == equals) {
 						return eval(randomChoice.choices[i]);
 					}
 				}
@@ -534,14 +1127,19 @@ namespace passlang {
 					freeElements++;
 				}
 			}
+			if (failed()) {
+				return {};
+			}
 			if (freeChance < 0) {
-				throw std::runtime_error("Interpreter::evalRandomChoice: used more than 100 percents as chances");
+				fail(ErrorCode::chanceOverflow, "Interpreter::evalRandomChoice: used more than 100 percents as chances");
+				return {};
 			}
 
 			if (freeElements) {
 				chanceOnFree = (float)freeChance / freeElements;
 				if (chanceOnFree < 0.0001 && freeChance > 0) {
-					throw std::runtime_error("Interpreter::evalRandomChoide: too small chance for free elements, can't use");
+					fail(ErrorCode::chanceTooSmall, "Interpreter::evalRandomChoide: too small chance for free elements, can't use");
+					return {};
 				}
 			}
 
@@ -552,6 +1150,9 @@ namespace passlang {
 				}
 				else if (randomChoice.choices[i].chance.type == RandomChoiceChanceType::operand) {
 					chance += eval(randomChoice.choices[i].chance.get<Operand>());
+					if (failed()) {
+						return {};
+					}
 				}
 				else {
 					chance += chanceOnFree;
@@ -563,32 +1164,49 @@ namespace passlang {
 			}
 
 			if (randomChoice.type == RandomChoiceValueType::checksrow) {
-				return RandomChoiceResult(RandomChoiceResultType::vector, std::vector<C_Check>());
+				return RandomChoiceResult(RandomChoiceResultType::vector, std::pmr::vector<C_Check>(memoryResource));
 			}
-			throw std::runtime_error("Interpreter::evalRandomChoice: can't choose item");
+			fail(ErrorCode::noChoice, "Interpreter::evalRandomChoice: can't choose item");
+			return {};
 		}
 
 		RandomChoiceResult eval(RandomChoiceElement randomChoiceElement) {
 			if (randomChoiceElement.value.type == RandomChoiceValueType::operand) {
-				return RandomChoiceResult(RandomChoiceResultType::number, eval(randomChoiceElement.value.get<Operand>()));
+				int value = eval(randomChoiceElement.value.get<Operand>());
+				if (failed()) {
+					return {};
+				}
+				return RandomChoiceResult(RandomChoiceResultType::number, value);
 			}
 			else if (randomChoiceElement.value.type == RandomChoiceValueType::checksrow) {
-				return RandomChoiceResult(RandomChoiceResultType::vector, eval(randomChoiceElement.value.get<ChecksRowElement>()));
+				std::pmr::vector<C_Check> checks = eval(randomChoiceElement.value.get<ChecksRowElement>());
+				if (failed()) {
+					return {};
+				}
+				return RandomChoiceResult(RandomChoiceResultType::vector, checks);
 			}
-			throw std::runtime_error("Interpreter::evalRandomChoiceElement: can't use given RandomChoiceElement");
+			fail(ErrorCode::invalidNode, "Interpreter::evalRandomChoiceElement: can't use given RandomChoiceElement");
+			return {};
 		}
 
-		std::vector<C_Check> eval(Loop loop) {
-			std::vector<C_Check> checks;
+		std::pmr::vector<C_Check> eval(const Loop& loop) {
+			OffsetScope scope(currentOffset, loop.offset);
+			std::pmr::vector<C_Check> checks(memoryResource);
 			int length = eval(loop.length);
 			int loop_length = loop.checks.size();
+			if (failed()) {
+				return {};
+			}
 
 			loopIterators.push_back(0);
 			int iteratorIndex = loopIterators.size() - 1;
 
-			for (int j = 0; j < length; j++) {
+			for (int j = 0; j < length && !failed(); j++) {
 				for (int i = 0; i < loop_length; i++) {
-					std::vector<C_Check> check = eval(loop.checks[i]);
+					std::pmr::vector<C_Check> check = eval(loop.checks[i]);
+					if (failed()) {
+						break;
+					}
 					checks.insert(checks.end(), check.begin(), check.end());
 					loopIterators[iteratorIndex]++;
 				}
@@ -602,13 +1220,16 @@ namespace passlang {
 		int eval(RandomRange randomRange) {
 			int start = eval(randomRange.start);
 			int finish = eval(randomRange.finish);
+			if (failed()) {
+				return 0;
+			}
 
 			if (finish < start) {
 				int temp = start;
 				start = finish;
 				finish = temp;
 			}
-			return randrangeCallback(start, finish);
+			return callRandrange(start, finish);
 		}
 
 		int eval(CheckElement checkElement) {
@@ -625,7 +1246,11 @@ namespace passlang {
 				return eval(checkElement.get<RandomRange>());
 			}
 			else if (checkElement.type == CheckElementType::randomchoice) {
-				return eval(checkElement.get<RandomChoice>()).get<int>();
+				RandomChoiceResult result = eval(checkElement.get<RandomChoice>());
+				if (failed()) {
+					return 0;
+				}
+				return result.get<int>();
 			}
 			else if (checkElement.type == CheckElementType::numofchecks) {
 				return numberOfChecks;
@@ -633,23 +1258,142 @@ namespace passlang {
 			else if (checkElement.type == CheckElementType::loopiterator) {
 				return getIterator(checkElement.get<int>());
 			}
-			throw std::runtime_error("Interpreter::evalCheckElement: can't use given CheckElement");
+			fail(ErrorCode::invalidNode, "Interpreter::evalCheckElement: can't use given CheckElement");
+			return 0;
 		}
 
 		C_Check eval(Check check) {
+			OffsetScope scope(currentOffset, check.offset);
+			C_Check c_check = construct(check);
+			if (!uniqueChecks || failed()) {
+				return c_check;
+			}
+
+			size_t attempts = 0;
+			while (!evaluatedChecks.insert(c_check)) {
+				std::string checkString = std::to_string(c_check.world) + "." + std::to_string(c_check.x) + "." + std::to_string(c_check.y);
+				if (!isRandom(check.world) && !isRandom(check.x) && !isRandom(check.y)) {
+					fail(ErrorCode::repeatedCheck, "Interpreter::evalCheck: check " + checkString + " is repeated and has no random parts to redraw");
+					return {};
+				}
+				if (domain && domainChecks >= domain->size()) {
+					fail(ErrorCode::uniqueChecksExhausted, "Interpreter::evalCheck: all " + std::to_string(domain->size()) + " checks of the domain are already evaluated, last repeated check " + checkString);
+					return {};
+				}
+				if (attempts == maxRedraws) {
+					std::string remaining = domain ? ", " + std::to_string(domain->size() - domainChecks) + " checks of the domain are still free" : "";
+					fail(ErrorCode::redrawLimit, "Interpreter::evalCheck: redraw limit reached, check " + checkString + " is still repeated after " + std::to_string(maxRedraws) + " redraws" + remaining);
+					return {};
+				}
+				attempts++;
+				redraws++;
+				c_check = construct(check);
+				if (failed()) {
+					return {};
+				}
+			}
+			if (domain && domain->contains(c_check.world, c_check.x, c_check.y)) {
+				domainChecks++;
+			}
+			return c_check;
+		}
+
+		C_Check construct(Check check) {
 			int world, x, y;
 
 			world = eval(check.world);
 			x = eval(check.x);
 			y = eval(check.y);
-			C_Check c_check = checkConstructor(world, x, y);
+			if (failed()) {
+				return {};
+			}
+			if (domain) {
+				resolve(check, world, x, y);
+				if (failed()) {
+					return {};
+				}
+			}
+			C_Check c_check = callCheckConstructor(world, x, y);
 
 			return c_check;
 		}
 
+		// Replaces random placeholders with values drawn from domain and checks the rest against it
+		void resolve(const Check& check, int& world, int& x, int& y) {
+			if (world == randomPlaceholder) {
+				const std::vector<int>& allowed = domain->allowedWorlds();
+				int index = callRandrange(0, int(allowed.size()) - 1);
+				if (failed()) {
+					return;
+				}
+				if (index < 0 || size_t(index) >= allowed.size()) {
+					fail(ErrorCode::callback, "Interpreter::resolveCheck: randrangeCallback returned " + std::to_string(index) + " out of its range");
+					return;
+				}
+				world = allowed[size_t(index)];
+			}
+			else if (!domain->hasWorld(world)) {
+				fail(ErrorCode::outOfDomain, "Interpreter::resolveCheck: world " + std::to_string(world) + " isn't in the domain", check.offset);
+				return;
+			}
+
+			const Domain::Bounds& bounds = domain->bounds(world);
+			if (x == randomPlaceholder) {
+				x = callRandrange(bounds.xStart, bounds.xFinish);
+			}
+			else if (x < bounds.xStart || x > bounds.xFinish) {
+				fail(ErrorCode::outOfDomain, "Interpreter::resolveCheck: x " + std::to_string(x) + " isn't in bounds of world " + std::to_string(world), check.offset);
+			}
+			if (y == randomPlaceholder) {
+				y = callRandrange(bounds.yStart, bounds.yFinish);
+			}
+			else if (y < bounds.yStart || y > bounds.yFinish) {
+				fail(ErrorCode::outOfDomain, "Interpreter::resolveCheck: y " + std::to_string(y) + " isn't in bounds of world " + std::to_string(world), check.offset);
+			}
+		}
+
+		// Forgets evaluated checks of uniqueness mode and resets redraws counter
+		void resetUniqueChecks() {
+			evaluatedChecks.clear();
+			domainChecks = 0;
+			redraws = 0;
+		}
+
+		static bool isRandom(CheckElement checkElement) {
+			if (checkElement.type == CheckElementType::random || checkElement.type == CheckElementType::randomrange || checkElement.type == CheckElementType::randomchoice) {
+				return true;
+			}
+			else if (checkElement.type == CheckElementType::expression) {
+				return isRandom(checkElement.get<ExpressionNode>());
+			}
+			return false;
+		}
+
+		static bool isRandom(ExpressionNode expression) {
+			return isRandom(expression.firstOperand) || isRandom(expression.secondOperand);
+		}
+
+		static bool isRandom(Operand operand) {
+			if (operand.type == OperandType::randomrange || operand.type == OperandType::randomchoice) {
+				return true;
+			}
+			else if (operand.type == OperandType::expression) {
+				return isRandom(operand.get<ExpressionNode>());
+			}
+			return false;
+		}
+
 		int eval(ExpressionNode expression) {
 			int firstOperand = eval(expression.firstOperand);
 			int secondOperand = eval(expression.secondOperand);
+			if (failed()) {
+				return 0;
+			}
+
+			if ((expression.operation == "/" || expression.operation == "%") && (secondOperand == 0 || (firstOperand == INT_MIN && secondOperand == -1))) {
+				fail(ErrorCode::invalidArithmetic, std::string("Interpreter::evalExpression: can't calculate ") + std::to_string(firstOperand) + " " + expression.operation + " " + std::to_string(secondOperand));
+				return 0;
+			}
 
 			if (expression.operation == "+") {
 				return firstOperand + secondOperand;
@@ -667,7 +1411,8 @@ namespace passlang {
 				return firstOperand % secondOperand;
 			}
 
-			throw std::runtime_error(std::string("Interpreter::parseExpression: can't use given operator: ") + expression.operation);
+			fail(ErrorCode::unknownOperator, std::string("Interpreter::parseExpression: can't use given operator: ") + expression.operation);
+			return 0;
 		}
 
 		int eval(Operand operand) {
@@ -681,7 +1426,11 @@ namespace passlang {
 				return eval(operand.get<RandomRange>());
 			}
 			else if (operand.type == OperandType::randomchoice) {
-				return eval(operand.get<RandomChoice>()).get<int>();
+				RandomChoiceResult result = eval(operand.get<RandomChoice>());
+				if (failed()) {
+					return 0;
+				}
+				return result.get<int>();
 			}
 			else if (operand.type == OperandType::numofchecks) {
 				return numberOfChecks;
@@ -690,16 +1439,47 @@ namespace passlang {
 				return getIterator(operand.get<int>());
 			}
 
-			throw std::runtime_error("Interpreter::evalOperand: can't use given Operand");
+			fail(ErrorCode::invalidNode, "Interpreter::evalOperand: can't use given Operand");
+			return 0;
 		}
 
 		int getIterator(int index) {
 			if (index < 0 || index >= loopIterators.size()) {
-				throw std::runtime_error(std::string("Interpreter::getInterator: can't find loop with iterator: i") + std::to_string(index));
+				fail(ErrorCode::unknownIterator, std::string("Interpreter::getInterator: can't find loop with iterator: i") + std::to_string(index));
+				return 0;
 			}
 			return loopIterators[index];
 		}
 	};
+
+
+	/************* PROGRAM *************/
+	// Parsed expression which owns its nodes, so it can be cached and evaluated many times (also from several threads).
+	// Tokens, nodes and the pool are allocated from the resource given to compile
+	struct Program {
+		std::shared_ptr<Deleter::Pool> pool;
+		std::pmr::vector<ChecksRowElement> checks;
+	};
+
+	Result<Program> tryCompile(const std::string& expression, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	Program compile(const std::string& expression, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// Also fails with ErrorCode::outOfDomain if a coordinate constant for every "n" can't be in the domain
+	Result<Program> tryCompile(const std::string& expression, const Domain& domain, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	Program compile(const std::string& expression, const Domain& domain, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// First check whose constant world, x or y can't be in the domain, ErrorCode::none if there is none.
+	// Constant arithmetic and random choices with one outcome are folded first, "n" is kept (it's constant
+	// only after specialize). World is checked to be in the domain (excluded worlds too), x and y to be in
+	// its bounds, or in bounds of some world if world isn't constant. Checks which never run aren't checked:
+	// bodies of loops with constant zero length and elements of choices of checks which are never taken
+	Error checkDomain(const Program& program, const Domain& domain);
+
+	// Checks and temporary values of evaluation are allocated from interpreter.resource()
+	Result<std::pmr::vector<C_Check>> tryEvaluate(const Program& program, Interpreter& interpreter);
+	std::pmr::vector<C_Check> evaluate(const Program& program, Interpreter& interpreter);
 }
 
 std::function<std::vector<passlang::C_Check>(int, std::string)> initPasslang(std::function<passlang::C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback);
+// Random placeholders are drawn from the domain, so checkConstructor gets only resolved coordinates
+std::function<std::vector<passlang::C_Check>(int, std::string)> initPasslang(const passlang::Domain& domain, std::function<passlang::C_Check(int, int, int)> checkConstructor, std::function<int(int, int)> randrangeCallback);
@@ -0,0 +1,179 @@
+#include "serializer.h"
+
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+
+namespace passlang {
+	namespace Serializer {
+		namespace {
+			void writeInt32(char* buffer, uint32_t value) {
+				buffer[0] = char(value & 0xff);
+				buffer[1] = char((value >> 8) & 0xff);
+				buffer[2] = char((value >> 16) & 0xff);
+				buffer[3] = char((value >> 24) & 0xff);
+			}
+
+			// Returns false instead of raising an error, so it can be used from the destructor
+			bool writeAll(int fd, const char* data, size_t size) {
+				while (size) {
+					ssize_t written = ::write(fd, data, size);
+					if (written < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						return false;
+					}
+					data += written;
+					size -= size_t(written);
+				}
+				return true;
+			}
+		}
+
+		size_t textSizeBound(size_t checksCount) {
+			return checksCount * maxTextCheckSize;
+		}
+
+		size_t binarySize(size_t checksCount) {
+			return binaryHeaderSize + checksCount * binaryCheckSize;
+		}
+
+		Result<size_t> tryWriteText(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize) {
+			if (bufferSize < textSizeBound(checksCount)) {
+				return Error{ErrorCode::bufferTooSmall, noOffset, "Serializer::writeText: buffer is too small"};
+			}
+
+			// Bound is checked once above, so every to_chars call has enough space
+			char* current = buffer;
+			char* end = buffer + bufferSize;
+			for (size_t i = 0; i < checksCount; i++) {
+				if (i) {
+					*current++ = ' ';
+				}
+				current = std::to_chars(current, end, checks[i].world).ptr;
+				*current++ = '.';
+				current = std::to_chars(current, end, checks[i].x).ptr;
+				*current++ = '.';
+				current = std::to_chars(current, end, checks[i].y).ptr;
+			}
+			return size_t(current - buffer);
+		}
+
+		Result<size_t> tryWriteBinary(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize) {
+			if (bufferSize < binarySize(checksCount)) {
+				return Error{ErrorCode::bufferTooSmall, noOffset, "Serializer::writeBinary: buffer is too small"};
+			}
+			if (checksCount > UINT32_MAX) {
+				return Error{ErrorCode::bufferTooSmall, noOffset, "Serializer::writeBinary: too many checks for one frame"};
+			}
+
+			writeInt32(buffer, uint32_t(checksCount));
+			char* current = buffer + binaryHeaderSize;
+			for (size_t i = 0; i < checksCount; i++) {
+				writeInt32(current, uint32_t(checks[i].world));
+				writeInt32(current + 4, uint32_t(checks[i].x));
+				writeInt32(current + 8, uint32_t(checks[i].y));
+				current += binaryCheckSize;
+			}
+			return size_t(current - buffer);
+		}
+
+		size_t writeText(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize) {
+			return tryWriteText(checks, checksCount, buffer, bufferSize).value();
+		}
+
+		size_t writeBinary(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize) {
+			return tryWriteBinary(checks, checksCount, buffer, bufferSize).value();
+		}
+
+
+		FdWriter::FdWriter(int fd, size_t bufferSize) : fd(fd), buffer(bufferSize ? bufferSize : 1) {}
+
+		FdWriter::~FdWriter() {
+			writeAll(fd, buffer.data(), used);
+		}
+
+		Result<char*> FdWriter::tryReserve(size_t size) {
+			if (buffer.size() - used < size) {
+				Result<size_t> flushed = tryFlush();
+				if (!flushed) {
+					return flushed.error();
+				}
+				if (buffer.size() < size) {
+					buffer.resize(size);
+				}
+			}
+			return buffer.data() + used;
+		}
+
+		Result<size_t> FdWriter::tryWrite(const std::vector<C_Check>& checks, Format format) {
+			return tryWrite(checks.data(), checks.size(), format);
+		}
+
+		Result<size_t> FdWriter::tryWrite(const C_Check* checks, size_t checksCount, Format format) {
+			size_t size = format == Format::text ? textSizeBound(checksCount) + 1 : binarySize(checksCount);
+			Result<char*> data = tryReserve(size);
+			if (!data) {
+				return data.error();
+			}
+
+			Result<size_t> written = format == Format::text ? tryWriteText(checks, checksCount, data.value(), size) : tryWriteBinary(checks, checksCount, data.value(), size);
+			if (!written) {
+				return written;
+			}
+			if (format == Format::text) {
+				data.value()[written.value()++] = '\n';
+			}
+			used += written.value();
+			return written;
+		}
+
+		Result<size_t> FdWriter::tryWriteRaw(const char* data, size_t size) {
+			if (size >= buffer.size()) {
+				Result<size_t> flushed = tryFlush();
+				if (!flushed) {
+					return flushed;
+				}
+				if (!writeAll(fd, data, size)) {
+					return Error{ErrorCode::writeFailed, noOffset, std::string("Serializer::FdWriter: write failed: ") + std::strerror(errno)};
+				}
+				return size;
+			}
+			Result<char*> reserved = tryReserve(size);
+			if (!reserved) {
+				return reserved.error();
+			}
+			std::memcpy(reserved.value(), data, size);
+			used += size;
+			return size;
+		}
+
+		Result<size_t> FdWriter::tryFlush() {
+			size_t size = used;
+			used = 0;
+			if (!writeAll(fd, buffer.data(), size)) {
+				return Error{ErrorCode::writeFailed, noOffset, std::string("Serializer::FdWriter: write failed: ") + std::strerror(errno)};
+			}
+			return size;
+		}
+
+		void FdWriter::write(const std::vector<C_Check>& checks, Format format) {
+			tryWrite(checks, format).value();
+		}
+
+		void FdWriter::write(const C_Check* checks, size_t checksCount, Format format) {
+			tryWrite(checks, checksCount, format).value();
+		}
+
+		void FdWriter::writeRaw(const char* data, size_t size) {
+			tryWriteRaw(data, size).value();
+		}
+
+		void FdWriter::flush() {
+			tryFlush().value();
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "passlang.h"
+
+
+namespace passlang {
+	/************* SERIALIZER *************/
+	// Text format matches operator<<: "world.x.y" per check, checks separated by a space.
+	// Binary format is little-endian: uint32 number of checks, then int32 world, x, y for every check.
+	namespace Serializer {
+		const size_t maxTextCheckSize = 3 * 11 + 2 + 1; // three signed ints, two dots, separator
+		const size_t binaryHeaderSize = 4;
+		const size_t binaryCheckSize = 3 * 4;
+
+		size_t textSizeBound(size_t checksCount);
+		size_t binarySize(size_t checksCount);
+
+		// Return number of written bytes, fail with ErrorCode::bufferTooSmall if buffer is smaller than the *SizeBound/*Size result
+		Result<size_t> tryWriteText(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize);
+		Result<size_t> tryWriteBinary(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize);
+		size_t writeText(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize);
+		size_t writeBinary(const C_Check* checks, size_t checksCount, char* buffer, size_t bufferSize);
+
+		enum class Format {
+			text = 0,
+			binary
+		};
+
+		// Buffers whole check sequences and writes them to a file descriptor in large chunks.
+		// Text sequences are terminated with '\n', binary ones are framed by their header.
+		// try* methods fail with ErrorCode::writeFailed instead of raising it
+		class FdWriter {
+		private:
+			int fd;
+			std::vector<char> buffer;
+			size_t used = 0;
+
+			Result<char*> tryReserve(size_t size);
+
+		public:
+			static const size_t defaultBufferSize = 1 << 20;
+
+			FdWriter(int fd, size_t bufferSize = defaultBufferSize);
+			~FdWriter();
+
+			FdWriter(const FdWriter&) = delete;
+			FdWriter& operator=(const FdWriter&) = delete;
+
+			// Return number of bytes taken into the buffer or written
+			Result<size_t> tryWrite(const std::vector<C_Check>& checks, Format format);
+			Result<size_t> tryWrite(const C_Check* checks, size_t checksCount, Format format);
+			Result<size_t> tryWriteRaw(const char* data, size_t size);
+			Result<size_t> tryFlush();
+
+			void write(const std::vector<C_Check>& checks, Format format);
+			void write(const C_Check* checks, size_t checksCount, Format format);
+			void writeRaw(const char* data, size_t size);
+			void flush();
+		};
+	}
+}
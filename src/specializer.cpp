@@ -0,0 +1,15 @@
+#include "specializer.h"
+
+
+namespace passlang {
+	Program specialize(const Program& program, int numberOfChecks) {
+		// Residual lives in the same memory resource as the original program
+		std::pmr::memory_resource* resource = program.pool->resource();
+		Program residual{std::allocate_shared<Deleter::Pool>(std::pmr::polymorphic_allocator<Deleter::Pool>(resource), resource), std::pmr::vector<ChecksRowElement>(resource)};
+		Deleter::Scope scope(*residual.pool);
+
+		Specializer specializer(numberOfChecks);
+		residual.checks = specializer.specialize(program.checks);
+		return residual;
+	}
+}
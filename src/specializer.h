@@ -0,0 +1,334 @@
+#pragma once
+
+#include <climits>
+#include "passlang.h"
+
+
+namespace passlang {
+	/************* SPECIALIZER *************/
+	// Builds residual program for fixed numberOfChecks: "n" is substituted, constant arithmetic,
+	// loop lengths and chances are folded, and random choices with only one possible outcome are
+	// replaced by that outcome. Loop iterators and genuinely random parts are left for Interpreter.
+	// Elements which never produce checks are dropped only from the top level row: iterators count elements
+	// of loop bodies, so there they are kept as loops without iterations. Every node of the result, leaves
+	// included, is allocated in the current Deleter pool, so it outlives the original program
+	class Specializer {
+	public:
+		int numberOfChecks;
+		bool substituteNumberOfChecks = true; // false keeps "n", so only parts constant for every n are folded
+
+		Specializer(int numberOfChecks) {
+			this->numberOfChecks = numberOfChecks;
+		}
+
+		std::pmr::vector<ChecksRowElement> specialize(const std::pmr::vector<ChecksRowElement>& checks) {
+			std::pmr::vector<ChecksRowElement> result(Deleter::currentResource());
+			for (auto i: checks) {
+				specialize(i, result);
+			}
+			return result;
+		}
+
+		// Appends residual of the element, nothing if it never produces checks
+		void specialize(ChecksRowElement check, std::pmr::vector<ChecksRowElement>& result) {
+			if (check.type == ChecksRowElementType::check) {
+				result.push_back(ChecksRowElement(ChecksRowElementType::check, specialize(check.get<Check>())));
+			}
+			else if (check.type == ChecksRowElementType::loop) {
+				Loop loop = specialize(check.get<Loop>());
+				if (loop.length.type != OperandType::number || loop.length.get<int>() > 0) {
+					result.push_back(ChecksRowElement(ChecksRowElementType::loop, loop));
+				}
+			}
+			else if (check.type == ChecksRowElementType::randomcheckchoice) {
+				RandomChoice randomChoice = specialize(check.get<RandomChoice>());
+				int chosen = chooseStatically(randomChoice);
+				if (chosen == noChoice) {
+					result.push_back(ChecksRowElement(ChecksRowElementType::randomcheckchoice, randomChoice));
+				}
+				else if (chosen != neverChosen) {
+					specialize(randomChoice.choices[size_t(chosen)].value.get<ChecksRowElement>(), result);
+				}
+			}
+			else {
+				raise(Error{ErrorCode::invalidNode, noOffset, "Specializer::specializeChecksRowElement: can't use given ChecksRowElement"});
+			}
+		}
+
+		Check specialize(Check check) {
+			return Check{specialize(check.world), specialize(check.x), specialize(check.y), check.offset};
+		}
+
+		Loop specialize(const Loop& loop) {
+			std::pmr::vector<ChecksRowElement> checks(Deleter::currentResource());
+			for (auto i: loop.checks) {
+				checks.push_back(specializeElement(i));
+			}
+			return Loop{specialize(loop.length), checks, loop.offset};
+		}
+
+		CheckElement specialize(CheckElement checkElement) {
+			if (checkElement.type == CheckElementType::number || checkElement.type == CheckElementType::loopiterator) {
+				return CheckElement(checkElement.type, checkElement.get<int>());
+			}
+			else if (checkElement.type == CheckElementType::random) {
+				return checkElement; // holds no value
+			}
+			else if (checkElement.type == CheckElementType::numofchecks) {
+				return substituteNumberOfChecks ? CheckElement(CheckElementType::number, numberOfChecks) : checkElement;
+			}
+			else if (checkElement.type == CheckElementType::expression) {
+				return Operand2CheckElement(specialize(checkElement.get<ExpressionNode>()));
+			}
+			else if (checkElement.type == CheckElementType::randomrange) {
+				return Operand2CheckElement(specialize(checkElement.get<RandomRange>()));
+			}
+			else if (checkElement.type == CheckElementType::randomchoice) {
+				return Operand2CheckElement(specializeOperandChoice(checkElement.get<RandomChoice>()));
+			}
+			raise(Error{ErrorCode::invalidNode, noOffset, "Specializer::specializeCheckElement: can't use given CheckElement"});
+		}
+
+		Operand specialize(Operand operand) {
+			if (operand.type == OperandType::number || operand.type == OperandType::loopiterator) {
+				return Operand(operand.type, operand.get<int>());
+			}
+			else if (operand.type == OperandType::numofchecks) {
+				return substituteNumberOfChecks ? Operand(OperandType::number, numberOfChecks) : operand;
+			}
+			else if (operand.type == OperandType::expression) {
+				return specialize(operand.get<ExpressionNode>());
+			}
+			else if (operand.type == OperandType::randomrange) {
+				return specialize(operand.get<RandomRange>());
+			}
+			else if (operand.type == OperandType::randomchoice) {
+				return specializeOperandChoice(operand.get<RandomChoice>());
+			}
+			raise(Error{ErrorCode::invalidNode, noOffset, "Specializer::specializeOperand: can't use given Operand"});
+		}
+
+		Operand specialize(ExpressionNode expression) {
+			Operand first = specialize(expression.firstOperand);
+			Operand second = specialize(expression.secondOperand);
+
+			if (first.type == OperandType::number && second.type == OperandType::number) {
+				long long a = first.get<int>(), b = second.get<int>();
+				long long value = 0;
+				bool folded = true;
+
+				if (expression.operation == "+") {
+					value = a + b;
+				}
+				else if (expression.operation == "-") {
+					value = a - b;
+				}
+				else if (expression.operation == "*") {
+					value = a * b;
+				}
+				else if (expression.operation == "/" && b != 0) {
+					value = a / b;
+				}
+				else if (expression.operation == "%" && b != 0) {
+					value = a % b;
+				}
+				else {
+					folded = false;
+				}
+
+				// Division by zero and overflow are left to evaluation time
+				if (folded && value >= INT_MIN && value <= INT_MAX) {
+					return Operand(OperandType::number, int(value));
+				}
+			}
+			return Operand(OperandType::expression, ExpressionNode{first, expression.operation, second});
+		}
+
+		Operand specialize(RandomRange randomRange) {
+			Operand start = specialize(randomRange.start);
+			Operand finish = specialize(randomRange.finish);
+
+			// Both ends are included, so range of one number is that number
+			if (start.type == OperandType::number && finish.type == OperandType::number && start.get<int>() == finish.get<int>()) {
+				return start;
+			}
+			return Operand(OperandType::randomrange, RandomRange{start, finish});
+		}
+
+		RandomChoice specialize(const RandomChoice& randomChoice) {
+			RandomChoice result(randomChoice.type, std::pmr::vector<RandomChoiceElement>(Deleter::currentResource()), randomChoice.offset);
+
+			for (auto i: randomChoice.choices) {
+				RandomChoiceElement element = specialize(i);
+
+				// Equalable element with constant chance and equals is either always or never taken.
+				// Never taken ones are dropped, always taken one ends the choice if nothing before it
+				// may be taken or has side effects
+				if (element.equals.type == RandomChoiceChanceType::operand && isNumber(element.chance) && isNumber(element.equals)) {
+					if (element.chance.get<Operand>().get<int>() != element.equals.get<Operand>().get<int>()) {
+						continue;
+					}
+					if (isStatic(result)) {
+						result.choices = {element};
+						return result;
+					}
+				}
+				result.choices.push_back(element);
+			}
+			return result;
+		}
+
+		RandomChoiceElement specialize(RandomChoiceElement randomChoiceElement) {
+			RandomChoiceValue value = RandomChoiceValue(RandomChoiceValueType::operand);
+			if (randomChoiceElement.value.type == RandomChoiceValueType::operand) {
+				value = RandomChoiceValue(RandomChoiceValueType::operand, specialize(randomChoiceElement.value.get<Operand>()));
+			}
+			else if (randomChoiceElement.value.type == RandomChoiceValueType::checksrow) {
+				value = RandomChoiceValue(RandomChoiceValueType::checksrow, specializeElement(randomChoiceElement.value.get<ChecksRowElement>()));
+			}
+			else {
+				raise(Error{ErrorCode::invalidNode, noOffset, "Specializer::specializeRandomChoiceElement: can't use given RandomChoiceElement"});
+			}
+
+			return RandomChoiceElement{value, specialize(randomChoiceElement.chance), specialize(randomChoiceElement.equals)};
+		}
+
+		RandomChoiceChance specialize(RandomChoiceChance chance) {
+			if (chance.type == RandomChoiceChanceType::operand) {
+				return RandomChoiceChance(RandomChoiceChanceType::operand, specialize(chance.get<Operand>()));
+			}
+			return chance;
+		}
+
+	private:
+		static const int noChoice = -1;
+		static const int neverChosen = -2;
+
+		Operand specializeOperandChoice(const RandomChoice& randomChoice) {
+			RandomChoice result = specialize(randomChoice);
+			int chosen = chooseStatically(result);
+			if (chosen >= 0) {
+				return result.choices[size_t(chosen)].value.get<Operand>();
+			}
+			return Operand(OperandType::randomchoice, result);
+		}
+
+		// Residual of one element is at most one element. Empty one is kept as a loop without
+		// iterations, so it still takes its place in the loop body and doesn't shift iterators
+		ChecksRowElement specializeElement(ChecksRowElement check) {
+			std::pmr::vector<ChecksRowElement> checks(Deleter::currentResource());
+			specialize(check, checks);
+			if (checks.size()) {
+				return checks[0];
+			}
+			Loop loop{Operand(OperandType::number, 0), std::pmr::vector<ChecksRowElement>(Deleter::currentResource())};
+			return ChecksRowElement(ChecksRowElementType::loop, loop);
+		}
+
+		static bool isNumber(RandomChoiceChance chance) {
+			return chance.type == RandomChoiceChanceType::operand && chance.get<Operand>().type == OperandType::number;
+		}
+
+		// Whether evaluating elements of the choice can't return early and has no side effects
+		static bool isStatic(const RandomChoice& randomChoice) {
+			for (auto i: randomChoice.choices) {
+				if (i.equals.type == RandomChoiceChanceType::operand) {
+					return false;
+				}
+				if (i.chance.type == RandomChoiceChanceType::operand && !isNumber(i.chance)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Index of the element Interpreter::eval(RandomChoice) takes for every random value, neverChosen if it
+		// never takes any (valid only for choice of checks), or noChoice if result is really random or may fail
+		static int chooseStatically(const RandomChoice& randomChoice) {
+			if (randomChoice.choices.size() == 1 && randomChoice.choices[0].equals.type == RandomChoiceChanceType::operand) {
+				RandomChoiceElement element = randomChoice.choices[0];
+				if (isNumber(element.chance) && isNumber(element.equals) && element.chance.get<Operand>().get<int>() == element.equals.get<Operand>().get<int>()) {
+					return 0;
+				}
+				return noChoice;
+			}
+			if (!isStatic(randomChoice)) {
+				return noChoice;
+			}
+
+			// Same arithmetic as Interpreter::eval(RandomChoice), tried for every possible random value
+			int freeChance = 100;
+			int freeElements = 0;
+			for (auto i: randomChoice.choices) {
+				if (i.chance.type == RandomChoiceChanceType::operand) {
+					freeChance -= i.chance.get<Operand>().get<int>();
+				}
+				else {
+					freeElements++;
+				}
+			}
+			if (freeChance < 0) {
+				return noChoice;
+			}
+			float chanceOnFree = 0;
+			if (freeElements) {
+				chanceOnFree = (float)freeChance / (float)freeElements;
+				if (chanceOnFree < 0.0001 && freeChance > 0) {
+					return noChoice;
+				}
+			}
+
+			int chosen = neverChosen;
+			for (int random = 1; random <= 100; random++) {
+				int current = neverChosen;
+				float chance = 0;
+				for (size_t i = 0; i < randomChoice.choices.size(); i++) {
+					if (randomChoice.choices[i].chance.type == RandomChoiceChanceType::operand) {
+						chance += (float)randomChoice.choices[i].chance.get<Operand>().get<int>();
+					}
+					else {
+						chance += chanceOnFree;
+					}
+					if (chance >= (float)random) {
+						current = int(i);
+						break;
+					}
+				}
+				if (random != 1 && current != chosen) {
+					return noChoice;
+				}
+				chosen = current;
+			}
+
+			if (chosen == neverChosen && randomChoice.type == RandomChoiceValueType::operand) {
+				return noChoice; // fails at evaluation time, keep the error there
+			}
+			return chosen;
+		}
+
+		static CheckElement Operand2CheckElement(Operand operand) {
+			if (operand.type == OperandType::number) {
+				return CheckElement(CheckElementType::number, operand.get<int>());
+			}
+			else if (operand.type == OperandType::expression) {
+				return CheckElement(CheckElementType::expression, operand.get<ExpressionNode>());
+			}
+			else if (operand.type == OperandType::randomrange) {
+				return CheckElement(CheckElementType::randomrange, operand.get<RandomRange>());
+			}
+			else if (operand.type == OperandType::randomchoice) {
+				return CheckElement(CheckElementType::randomchoice, operand.get<RandomChoice>());
+			}
+			else if (operand.type == OperandType::numofchecks) {
+				return CheckElement(CheckElementType::numofchecks);
+			}
+			else if (operand.type == OperandType::loopiterator) {
+				return CheckElement(CheckElementType::loopiterator, operand.get<int>());
+			}
+			raise(Error{ErrorCode::invalidNode, noOffset, "Specializer::Operand2CheckElement: can't use given Operand"});
+		}
+	};
+
+	// Residual program of given one for fixed numberOfChecks, owns its own nodes in the same memory resource
+	Program specialize(const Program& program, int numberOfChecks);
+}
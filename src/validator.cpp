@@ -0,0 +1,14 @@
+#include "validator.h"
+
+
+namespace passlang {
+	Validation validate(const std::string& expression) {
+		Validator validator(expression, false, 0);
+		return validator.validate();
+	}
+
+	Validation validate(const std::string& expression, int numberOfChecks) {
+		Validator validator(expression, true, numberOfChecks);
+		return validator.validate();
+	}
+}
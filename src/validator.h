@@ -0,0 +1,590 @@
+#pragma once
+
+#include "passlang.h"
+
+
+namespace passlang {
+	/************* VALIDATOR *************/
+	struct Validation {
+		Error error;			// first syntax error, or first semantic one if syntax is valid
+		size_t minChecks = 0;	// bounds of number of generated checks
+		size_t maxChecks = 0;
+		bool bounded = true;	// false if maxChecks can't be found statically
+	};
+
+	// Checks expression in one pass over its characters without tokens and nodes, recursion depth and
+	// memory are bounded by nesting. Accepts the same grammar as tokenize + Parser and reports
+	// invalid iN references, chances over 100 percents, division by zero and bounds of output size.
+	// Values are tracked as intervals, with unknown "n" everything depending on it is unknown
+	class Validator {
+	private:
+		struct Lexeme {
+			TokenType type;
+			int value;
+			char operation;
+			size_t offset;
+			size_t next;
+		};
+
+		// Possible values of operand
+		struct Bounds {
+			bool known;
+			long long low, high;
+		};
+
+		// Possible number of checks, high == unbounded if unknown
+		struct Count {
+			unsigned long long low, high;
+		};
+
+		static constexpr unsigned long long unbounded = ~0ULL;
+
+		const std::string& expression;
+		size_t position = 0;
+		bool numberOfChecksKnown;
+		int numberOfChecks;
+		int depth = 0;				// loops around current position
+		Error numberError;			// tokenizer errors come first, wherever they are
+		Error syntaxError;
+		Error semanticError;
+
+		bool failed() const {
+			return syntaxError.code != ErrorCode::none;
+		}
+
+		void fail(ErrorCode code, size_t offset, std::string message) {
+			if (!failed()) {
+				syntaxError = Error{code, offset, message};
+			}
+		}
+
+		void warn(ErrorCode code, size_t offset, std::string message) {
+			if (semanticError.code == ErrorCode::none) {
+				semanticError = Error{code, offset, message};
+			}
+		}
+
+		static bool isDigit(char i) {
+			return i >= '0' && i <= '9';
+		}
+
+		// Same tokens as tokenize(), characters it ignores are skipped
+		Lexeme lex(size_t ind) {
+			while (ind < expression.length()) {
+				char i = expression[ind];
+				switch (i) {
+					case '(':
+						return Lexeme{TokenType::openBracket, 0, i, ind, ind + 1};
+					case ')':
+						return Lexeme{TokenType::closeBracket, 0, i, ind, ind + 1};
+					case '[':
+						return Lexeme{TokenType::openSquareBracket, 0, i, ind, ind + 1};
+					case ']':
+						return Lexeme{TokenType::closeSquareBracket, 0, i, ind, ind + 1};
+					case ';':
+						return Lexeme{TokenType::semicolon, 0, i, ind, ind + 1};
+					case '+':
+					case '-':
+					case '*':
+					case '/':
+					case '%':
+						return Lexeme{TokenType::operation, 0, i, ind, ind + 1};
+					case '.':
+						return Lexeme{TokenType::checkSeparator, 0, i, ind, ind + 1};
+					case ' ':
+						return Lexeme{TokenType::space, 0, i, ind, ind + 1};
+					case 'n':
+						return Lexeme{TokenType::numofChecksVariable, 0, i, ind, ind + 1};
+					case 'i':
+						if (ind + 1 < expression.length() && isDigit(expression[ind + 1])) {
+							Lexeme lexeme{TokenType::loopIteratorVariable, 0, i, ind, ind + 1};
+							readNumber(lexeme);
+							return lexeme;
+						}
+						break;
+					default:
+						if (isDigit(i)) {
+							Lexeme lexeme{TokenType::operand, 0, i, ind, ind};
+							readNumber(lexeme);
+							return lexeme;
+						}
+						break;
+				}
+				ind++;
+			}
+			return Lexeme{TokenType::end, 0, 0, expression.length(), expression.length() + 1};
+		}
+
+		void readNumber(Lexeme& lexeme) {
+			for (; lexeme.next < expression.length() && isDigit(expression[lexeme.next]); lexeme.next++) {
+				int digit = expression[lexeme.next] - '0';
+				if (lexeme.value > (INT_MAX - digit) / 10) {
+					if (numberError.code == ErrorCode::none) {
+						numberError = Error{ErrorCode::invalidNumber, lexeme.offset, lexeme.type == TokenType::operand ? "tokenize: number is too big" : "tokenize: loop iterator index is too big"};
+					}
+					lexeme.value = 0;
+				}
+				else {
+					lexeme.value = lexeme.value * 10 + digit;
+				}
+			}
+		}
+
+		Lexeme peekToken() {
+			if (position > expression.length()) {
+				fail(ErrorCode::unexpectedEnd, expression.length(), "Parser::peekToken: out of bounds");
+			}
+			return lex(position);
+		}
+
+		Lexeme popToken() {
+			if (position > expression.length()) {
+				fail(ErrorCode::unexpectedEnd, expression.length(), "Parser::popToken: out of bounds");
+				return lex(position);
+			}
+			Lexeme lexeme = lex(position);
+			position = lexeme.next;
+			return lexeme;
+		}
+
+		void skipSpace() {
+			while (peekToken().type == TokenType::space) {
+				popToken();
+			}
+		}
+
+		bool isMinus(Lexeme lexeme) {
+			return lexeme.type == TokenType::operation && lexeme.operation == '-';
+		}
+
+		static Bounds unknown() {
+			return Bounds{false, INT_MIN, INT_MAX};
+		}
+
+		static Bounds exactly(long long value) {
+			return Bounds{true, value, value};
+		}
+
+		static Bounds hull(Bounds a, Bounds b) {
+			if (!a.known || !b.known) {
+				return unknown();
+			}
+			return Bounds{true, std::min(a.low, b.low), std::max(a.high, b.high)};
+		}
+
+		static Bounds fromCorners(long long a, long long b, long long c, long long d) {
+			Bounds bounds{true, std::min(std::min(a, b), std::min(c, d)), std::max(std::max(a, b), std::max(c, d))};
+			if (bounds.low < INT_MIN || bounds.high > INT_MAX) {
+				return unknown();
+			}
+			return bounds;
+		}
+
+		static unsigned long long add(unsigned long long a, unsigned long long b) {
+			return a > unbounded - b ? unbounded : a + b;
+		}
+
+		static unsigned long long multiply(unsigned long long a, unsigned long long b) {
+			if (a == 0 || b == 0) {
+				return 0;
+			}
+			return a > unbounded / b ? unbounded : a * b;
+		}
+
+		Bounds calculate(Bounds first, char operation, Bounds second, size_t offset) {
+			if ((operation == '/' || operation == '%') && second.known && second.low == 0 && second.high == 0) {
+				warn(ErrorCode::invalidArithmetic, offset, std::string("Validator: division by zero in expression"));
+				return unknown();
+			}
+			if (!first.known || !second.known) {
+				return unknown();
+			}
+
+			long long a = first.low, b = first.high, c = second.low, d = second.high;
+			if (operation == '+') {
+				return fromCorners(a + c, a + d, b + c, b + d);
+			}
+			else if (operation == '-') {
+				return fromCorners(a - c, a - d, b - c, b - d);
+			}
+			else if (operation == '*') {
+				return fromCorners(a * c, a * d, b * c, b * d);
+			}
+			else if (c <= 0 && d >= 0) {
+				return unknown(); // divisor may be zero
+			}
+			else if (operation == '/') {
+				return fromCorners(a / c, a / d, b / c, b / d);
+			}
+			else if (a == b && c == d) {
+				return exactly(a % c);
+			}
+			long long limit = std::max(c < 0 ? -c : c, d < 0 ? -d : d) - 1;
+			return Bounds{true, a < 0 ? -limit : 0, b > 0 ? limit : 0};
+		}
+
+		void checkIterator(Lexeme lexeme) {
+			if (lexeme.value >= depth) {
+				warn(ErrorCode::unknownIterator, lexeme.offset, std::string("Validator: i") + std::to_string(lexeme.value) + " is used in " + std::to_string(depth) + " loops");
+			}
+		}
+
+		/* Mirrors of Parser methods: Count is number of checks of a row element, Bounds is value of an operand */
+
+		Count parseChecksRow() {
+			Count count{0, 0};
+			while (!failed() && peekToken().type != TokenType::end && peekToken().type != TokenType::closeBracket) {
+				Count check = parseCheck();
+				count = Count{add(count.low, check.low), add(count.high, check.high)};
+				skipSpace();
+			}
+			popToken();
+			return count;
+		}
+
+		Count parseCheck() {
+			skipSpace();
+
+			if (peekToken().type == TokenType::openSquareBracket) {
+				size_t old_position = position;
+				Error old_semanticError = semanticError;
+				Count randomCheckChoice = parseRandomChoice(true).count;
+				if (failed()) {
+					return {};
+				}
+				if (peekToken().type == TokenType::checkSeparator) {
+					position = old_position;
+					semanticError = old_semanticError;
+				}
+				else {
+					return randomCheckChoice;
+				}
+			}
+
+			Element world = parseCheckElement();
+			if (failed()) {
+				return {};
+			}
+			if (peekToken().type != TokenType::checkSeparator) {
+				if (peekToken().type == TokenType::openBracket) {
+					if (world.random) {
+						fail(ErrorCode::invalidNode, peekToken().offset, "Parser::CheckElement2Operand: can't use given CheckElement");
+						return {};
+					}
+					return parseLoop(world.bounds);
+				}
+				return Count{1, 1};
+			}
+			popToken();
+
+			parseCheckElement();
+			if (failed()) {
+				return {};
+			}
+			Lexeme separator = popToken();
+			if (separator.type != TokenType::checkSeparator) {
+				fail(ErrorCode::unexpectedToken, separator.offset, "Parser::parseCheck: can't find \".\" after x coordinate");
+				return {};
+			}
+
+			parseCheckElement();
+			return Count{1, 1};
+		}
+
+		struct Choice {
+			Count count;
+			Bounds bounds;
+		};
+
+		Choice parseRandomChoice(bool is_checks=false) {
+			Lexeme openBracket = popToken();
+			if (openBracket.type != TokenType::openSquareBracket) {
+				fail(ErrorCode::unexpectedToken, openBracket.offset, "Parser::parseRandomChoice: can't find \"[\" at the start");
+				return {};
+			}
+			skipSpace();
+
+			Choice choice{Count{unbounded, 0}, unknown()};
+			bool first = true;
+			bool chancesKnown = true;	// all chances without equalable are constants
+			bool overflowKnown = true;	// all of them have known lower bound
+			long long minimalChances = 0;
+			long long freeChance = 100;
+			int freeElements = 0;
+			while (!failed() && peekToken().type != TokenType::closeSquareBracket) {
+				Element element = parseRandomChoiceElement(is_checks);
+				if (failed()) {
+					return {};
+				}
+
+				choice.count = Count{std::min(choice.count.low, element.count.low), std::max(choice.count.high, element.count.high)};
+				choice.bounds = first ? element.bounds : hull(choice.bounds, element.bounds);
+				first = false;
+
+				if (element.hasEquals) {
+					// taken only if chance is equal to equalable
+				}
+				else if (element.hasChance) {
+					chancesKnown = chancesKnown && element.chance.known && element.chance.low == element.chance.high;
+					overflowKnown = overflowKnown && element.chance.known;
+					if (element.chance.known) {
+						minimalChances += element.chance.low;
+						freeChance -= element.chance.low;
+					}
+				}
+				else {
+					freeElements++;
+				}
+				skipSpace();
+			}
+			popToken(); // closeSquareBracket
+			if (failed()) {
+				return {};
+			}
+
+			if (overflowKnown && minimalChances > 100) {
+				warn(ErrorCode::chanceOverflow, openBracket.offset, "Validator: used more than 100 percents as chances");
+			}
+
+			// Choice of checks gives nothing if sum of chances is under the largest random value. Interpreter
+			// adds shares of free elements in float, several of them may sum up a bit under 100
+			bool canFail = true;
+			if (chancesKnown && freeChance >= 0) {
+				canFail = freeChance > 0 && freeElements != 1;
+			}
+			if (first) {
+				choice.count = Count{0, 0};
+			}
+			else if (canFail && is_checks) {
+				choice.count.low = 0;
+			}
+			return choice;
+		}
+
+		struct Element {
+			bool random = false;
+			Bounds bounds = unknown();
+			Count count = Count{1, 1};
+			bool hasChance = false;
+			bool hasEquals = false;
+			Bounds chance = unknown();
+		};
+
+		Element parseRandomChoiceElement(bool is_check=false) {
+			skipSpace();
+
+			Element element;
+			if (is_check) {
+				element.count = parseCheck();
+			}
+			else {
+				element.bounds = parseOperand();
+			}
+			if (failed()) {
+				return {};
+			}
+
+			if (peekToken().type == TokenType::semicolon) {
+				popToken();
+				Lexeme next = peekToken();
+				if (next.type == TokenType::space) {
+					fail(ErrorCode::unexpectedToken, next.offset, "Parser::parseRandomChoiceElement: chance must be set after semicolon without spaces");
+					return {};
+				}
+				element.hasChance = true;
+				element.chance = parseOperand();
+				if (failed()) {
+					return {};
+				}
+
+				if (peekToken().type == TokenType::semicolon) {
+					popToken();
+					next = peekToken();
+					if (next.type == TokenType::space) {
+						fail(ErrorCode::unexpectedToken, next.offset, "Parser::parseRandomChoiceElement: equalable must be set after semicolon without spaces");
+						return {};
+					}
+					element.hasEquals = true;
+					parseOperand();
+					if (failed()) {
+						return {};
+					}
+				}
+			}
+			return element;
+		}
+
+		Count parseLoop(Bounds length) {
+			Lexeme openBracket = popToken();
+			if (openBracket.type != TokenType::openBracket) {
+				fail(ErrorCode::unexpectedToken, openBracket.offset, "Parser::parseLoop: can't find \"(\" at the start");
+				return {};
+			}
+			depth++;
+			Count body = parseChecksRow();
+			depth--;
+			if (failed()) {
+				return {};
+			}
+
+			unsigned long long low = 0, high = unbounded;
+			if (length.known) {
+				low = length.low > 0 ? (unsigned long long)length.low : 0;
+				high = length.high > 0 ? (unsigned long long)length.high : 0;
+			}
+			return Count{multiply(low, body.low), multiply(high, body.high)};
+		}
+
+		Element parseCheckElement() {
+			Lexeme token = peekToken();
+			Element element;
+
+			if (token.type == TokenType::openBracket) {
+				element.bounds = parseExpression();
+			}
+			else if (token.type == TokenType::openSquareBracket) {
+				element.bounds = parseRandomChoice().bounds;
+			}
+			else if (token.type == TokenType::operand) {
+				element.bounds = exactly(popToken().value);
+			}
+			else if (token.type == TokenType::numofChecksVariable) {
+				element.bounds = numberOfChecksKnown ? exactly(numberOfChecks) : unknown();
+				popToken();
+			}
+			else if (token.type == TokenType::loopIteratorVariable) {
+				checkIterator(popToken());
+				element.bounds = Bounds{true, 0, INT_MAX};
+			}
+			else if (isMinus(token)) {
+				element.random = true;
+				popToken();
+				return element;
+			}
+			else {
+				fail(ErrorCode::unexpectedToken, token.offset, "Parser::parseCheckElement: can't use given Token");
+				return {};
+			}
+			if (failed()) {
+				return {};
+			}
+
+			if (isMinus(peekToken())) {
+				element.bounds = parseRandomRange(element.bounds);
+			}
+			return element;
+		}
+
+		Bounds parseRandomRange(Bounds start) {
+			popToken();
+			Bounds finish = parseOperand(true);
+			return hull(start, finish);
+		}
+
+		Bounds parseExpression() {
+			skipSpace();
+			Lexeme openBracket = popToken();
+			if (openBracket.type != TokenType::openBracket) {
+				fail(ErrorCode::unexpectedToken, openBracket.offset, "Parser::parseExpression: can't find \"(\" at the start");
+				return {};
+			}
+
+			Bounds first = parseOperand();
+			if (failed()) {
+				return {};
+			}
+			ExpressionBuilder builder(exactly(0), first, [this, &openBracket](Bounds firstOperand, std::string operation, Bounds secondOperand) {
+				return calculate(firstOperand, operation[0], secondOperand, openBracket.offset);
+			});
+
+			do {
+				skipSpace();
+				Lexeme operation = popToken();
+				if (operation.type != TokenType::operation) {
+					fail(ErrorCode::unexpectedToken, operation.offset, "Parser::parseExpression: can't find operation after operand");
+					return {};
+				}
+
+				Bounds operand = parseOperand();
+				if (failed()) {
+					return {};
+				}
+				builder.add(std::string(1, operation.operation), operand);
+				skipSpace();
+			} while (peekToken().type != TokenType::closeBracket);
+			popToken(); // closeBracket
+
+			return builder.finish();
+		}
+
+		Bounds parseOperand(bool is_finish=false) {
+			skipSpace();
+			Lexeme token = peekToken();
+			Bounds operand = unknown();
+
+			if (token.type == TokenType::operand) {
+				operand = exactly(popToken().value);
+			}
+			else if (token.type == TokenType::openBracket) {
+				operand = parseExpression();
+			}
+			else if (token.type == TokenType::openSquareBracket) {
+				operand = parseRandomChoice().bounds;
+			}
+			else if (token.type == TokenType::numofChecksVariable) {
+				operand = numberOfChecksKnown ? exactly(numberOfChecks) : unknown();
+				popToken();
+			}
+			else if (token.type == TokenType::loopIteratorVariable) {
+				checkIterator(popToken());
+				operand = Bounds{true, 0, INT_MAX};
+			}
+			else {
+				fail(ErrorCode::unexpectedToken, token.offset, "Parser::parseOperand: can't use given Token");
+				return {};
+			}
+			if (failed()) {
+				return {};
+			}
+
+			Lexeme next = peekToken();
+			if (isMinus(next)) {
+				if (is_finish) {
+					fail(ErrorCode::unexpectedToken, next.offset, "Parser::parseOperand: randrange takes only 2 points, but second \"-\" was found");
+					return {};
+				}
+				return parseRandomRange(operand);
+			}
+			return operand;
+		}
+
+	public:
+		Validator(const std::string& expression, bool numberOfChecksKnown, int numberOfChecks) : expression(expression) {
+			this->numberOfChecksKnown = numberOfChecksKnown;
+			this->numberOfChecks = numberOfChecks;
+		}
+
+		Validation validate() {
+			Count count = parseChecksRow();
+
+			// Parser stops at the first error or ")" on the top level, but tokenizer reads the whole expression
+			for (size_t ind = position; ind < expression.length(); ind = lex(ind).next);
+
+			Validation validation;
+			if (numberError.code != ErrorCode::none) {
+				validation.error = numberError;
+				return validation;
+			}
+			validation.error = failed() ? syntaxError : semanticError;
+			if (!failed()) {
+				validation.minChecks = count.low > SIZE_MAX ? SIZE_MAX : size_t(count.low);
+				validation.bounded = count.high != unbounded && count.high <= SIZE_MAX;
+				validation.maxChecks = validation.bounded ? size_t(count.high) : SIZE_MAX;
+			}
+			return validation;
+		}
+	};
+
+	Validation validate(const std::string& expression);
+	Validation validate(const std::string& expression, int numberOfChecks);
+}
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include "../src/analyzer.h"
+
+
+// Exact distributions of small programs, and limits stopping a large product early
+namespace {
+	int failures = 0;
+
+	void expect(bool condition, const std::string& message) {
+		if (!condition) {
+			std::cerr << message << "\n";
+			failures++;
+		}
+	}
+
+	bool near(double a, double b) {
+		return std::fabs(a - b) < 1e-9;
+	}
+
+	bool same(const std::map<int, double>& actual, const std::map<int, double>& expected) {
+		if (actual.size() != expected.size()) {
+			return false;
+		}
+		for (auto& i: expected) {
+			auto found = actual.find(i.first);
+			if (found == actual.end() || !near(found->second, i.second)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	passlang::Result<passlang::Analysis> analyze(const std::string& expression, int numberOfChecks) {
+		return passlang::tryAnalyze(passlang::compile(expression), numberOfChecks);
+	}
+
+	void testRandom() {
+		passlang::Result<passlang::Analysis> result = analyze("1.1-4.[5;50 6]", 1);
+		if (!result) {
+			expect(false, "1.1-4.[5;50 6]: " + result.error().message);
+			return;
+		}
+		passlang::Analysis& analysis = result.value();
+		expect(near(analysis.failureProbability, 0) && analysis.lengths.size() == 1 && near(analysis.lengths[1], 1), "1.1-4.[5;50 6]: wrong lengths");
+		expect(same(analysis.positions[0].x, {{1, 0.25}, {2, 0.25}, {3, 0.25}, {4, 0.25}}), "1.1-4.[5;50 6]: wrong x");
+		expect(same(analysis.positions[0].y, {{5, 0.5}, {6, 0.5}}), "1.1-4.[5;50 6]: wrong y");
+		expect(analysis.outputEntropyExact && near(analysis.outputEntropy, 3) && near(analysis.decisionEntropy, 3), "1.1-4.[5;50 6]: wrong entropy");
+	}
+
+	void testLoop() {
+		passlang::Result<passlang::Analysis> result = analyze("n(1.i0.(i0 * 2))", 3);
+		if (!result) {
+			expect(false, "n(1.i0.(i0 * 2)): " + result.error().message);
+			return;
+		}
+		passlang::Analysis& analysis = result.value();
+		expect(analysis.positions.size() == 3 && same(analysis.positions[2].y, {{4, 1}}), "n(1.i0.(i0 * 2)): wrong positions");
+		expect(analysis.outputEntropyExact && near(analysis.outputEntropy, 0) && near(analysis.decisionEntropy, 0), "n(1.i0.(i0 * 2)): wrong entropy");
+	}
+
+	void testFailure() {
+		passlang::Result<passlang::Analysis> result = analyze("1.(1 / 0-1).1", 1);
+		if (!result) {
+			expect(false, "1.(1 / 0-1).1: " + result.error().message);
+			return;
+		}
+		passlang::Analysis& analysis = result.value();
+		expect(near(analysis.failureProbability, 0.5) && same(analysis.positions[0].x, {{1, 1}}), "1.(1 / 0-1).1: wrong failure probability");
+	}
+
+	void testLimit() {
+		auto started = std::chrono::steady_clock::now();
+		passlang::Result<passlang::Analysis> result = analyze("(0-2047 * 0-2047).1.1", 1);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		expect(!result && result.error().code == passlang::ErrorCode::analysisLimit, "(0-2047 * 0-2047).1.1: isn't analysisLimit");
+		expect(seconds < 1, "(0-2047 * 0-2047).1.1: limit is reached after " + std::to_string(seconds) + " s");
+	}
+}
+
+int main() {
+	testRandom();
+	testLoop();
+	testFailure();
+	testLimit();
+	return failures ? 1 : 0;
+}
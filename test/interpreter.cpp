@@ -0,0 +1,124 @@
+#include <iostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../src/passlang.h"
+
+
+// Uniqueness mode: unique runs, repeated constant checks, redraw limit and exhausted domain; domain errors and checks
+namespace {
+	int failures = 0;
+	int state = 1;
+
+	int randrange(int start, int finish) {
+		state = state * 1103515245 + 12345;
+		return start + int(unsigned(state >> 8) % unsigned(finish - start + 1));
+	}
+
+	passlang::C_Check construct(int world, int x, int y) {
+		return {world, x, y};
+	}
+
+	passlang::ErrorCode errorOf(const passlang::Result<std::pmr::vector<passlang::C_Check>>& result) {
+		return result ? passlang::ErrorCode::none : result.error().code;
+	}
+
+	bool unique(const std::pmr::vector<passlang::C_Check>& checks) {
+		std::set<std::tuple<int, int, int>> seen;
+		for (auto& i: checks) {
+			if (!seen.insert({i.world, i.x, i.y}).second) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void expect(bool condition, const std::string& message) {
+		if (!condition) {
+			std::cerr << message << "\n";
+			failures++;
+		}
+	}
+
+	void testUniqueRuns() {
+		passlang::Domain domain(1, 0, 1);
+		passlang::Program program = passlang::compile("4(-.-.-)");
+		passlang::Interpreter interpreter(4, construct, randrange);
+		interpreter.uniqueChecks = true;
+		interpreter.domain = &domain;
+
+		// Every run takes the whole domain, so state left from a previous run would exhaust it
+		for (int run = 0; run < 3; run++) {
+			auto result = passlang::tryEvaluate(program, interpreter);
+			expect(result && result.value().size() == 4 && unique(result.value()), "unique run " + std::to_string(run) + " failed");
+		}
+	}
+
+	void testRepeatedCheck() {
+		passlang::Program program = passlang::compile("1.1.1 2.2.2 1.1.1");
+		passlang::Interpreter interpreter(3, construct, randrange);
+		interpreter.uniqueChecks = true;
+		expect(errorOf(passlang::tryEvaluate(program, interpreter)) == passlang::ErrorCode::repeatedCheck, "repeated constant check isn't repeatedCheck");
+	}
+
+	void testRedrawLimit() {
+		passlang::Program program = passlang::compile("3(1.1.0-1)");
+		passlang::Interpreter interpreter(3, construct, randrange);
+		interpreter.uniqueChecks = true;
+		interpreter.maxRedraws = 50;
+		auto result = passlang::tryEvaluate(program, interpreter);
+		expect(errorOf(result) == passlang::ErrorCode::redrawLimit, "third check of two possible isn't redrawLimit");
+		expect(interpreter.redraws >= 50, "redraws aren't counted");
+	}
+
+	void testExhausted() {
+		passlang::Domain domain(1, 0, 1);
+		passlang::Program program = passlang::compile("5(-.-.-)");
+		passlang::Interpreter interpreter(5, construct, randrange);
+		interpreter.uniqueChecks = true;
+		interpreter.domain = &domain;
+		expect(errorOf(passlang::tryEvaluate(program, interpreter)) == passlang::ErrorCode::uniqueChecksExhausted, "fifth check of 1x2x2 domain isn't uniqueChecksExhausted");
+	}
+
+	void testDomainErrors() {
+		passlang::Domain domain(2, 0, 1);
+		passlang::Result<bool> excluded = domain.tryExclude(0);
+		expect(excluded && excluded.value(), "tryExclude: world isn't excluded");
+		excluded = domain.tryExclude(1);
+		expect(!excluded && excluded.error().code == passlang::ErrorCode::invalidDomain, "tryExclude: last allowed world is excluded");
+		expect(!domain.trySetBounds(2, 0, 1, 0, 1), "trySetBounds: world out of the domain is accepted");
+		expect(!domain.trySetBounds(1, 1, 0, 0, 1), "trySetBounds: reversed bounds are accepted");
+		expect(domain.allowedWorlds().size() == 1 && domain.bounds(1).xFinish == 1, "failed try* calls changed the domain");
+	}
+
+	// Excluded worlds are only never drawn, and checks which never run aren't checked
+	void testCompileDomain() {
+		passlang::Domain domain(3, 0, 9);
+		domain.exclude(2);
+		const std::vector<std::string> accepted = {"2.1.1", "0(1.50.1) 1.1.1", "[1.50.1;0] 1.1.1", "[1.1.1;100 1.50.1]", "[1.50.1;1;2] 1.1.1"};
+		const std::vector<std::string> rejected = {"3.1.1", "1.10.1", "[1.50.1;50] 1.1.1", "n(1.1.50)"};
+		for (auto& i: accepted) {
+			passlang::Result<passlang::Program> program = passlang::tryCompile(i, domain);
+			expect(program.ok(), i + ": " + program.error().message);
+		}
+		for (auto& i: rejected) {
+			passlang::Result<passlang::Program> program = passlang::tryCompile(i, domain);
+			expect(!program && program.error().code == passlang::ErrorCode::outOfDomain, i + ": isn't outOfDomain");
+		}
+
+		passlang::Interpreter interpreter(1, construct, randrange);
+		interpreter.domain = &domain;
+		expect(passlang::tryEvaluate(passlang::compile("2.1.1"), interpreter).ok(), "excluded literal world fails evaluation");
+	}
+}
+
+int main() {
+	testUniqueRuns();
+	testRepeatedCheck();
+	testRedrawLimit();
+	testExhausted();
+	testDomainErrors();
+	testCompileDomain();
+	return failures ? 1 : 0;
+}
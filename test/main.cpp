@@ -3,7 +3,9 @@
 #include <vector>
 #include <cstdlib>
 #include <ctime>
+#include <unistd.h>
 #include "../src/passlang.h"
+#include "../src/serializer.h"
 
 
 enum World {
@@ -59,10 +61,8 @@ int main(int argc, char** args) {
 
 	std::vector<passlang::C_Check> results = getChecks(checksNumber, expression);
 
-	for (auto i: results) {
-		std::cout << i << " ";
-	}
-	std::cout << std::endl;
+	passlang::Serializer::FdWriter writer(STDOUT_FILENO);
+	writer.write(results, passlang::Serializer::Format::text);
 
 	return 0;
 }
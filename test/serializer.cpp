@@ -0,0 +1,128 @@
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "../src/serializer.h"
+
+
+// Short writes: while set, write(2) on this fd writes at most writeLimit bytes and fails once with EINTR
+static int limitedFd = -1;
+static size_t writeLimit = 0;
+static bool interrupt = false;
+
+extern "C" ssize_t write(int fd, const void* data, size_t size) {
+	if (fd == limitedFd) {
+		if (interrupt) {
+			interrupt = false;
+			errno = EINTR;
+			return -1;
+		}
+		size = std::min(size, writeLimit);
+	}
+	return syscall(SYS_write, fd, data, size);
+}
+
+namespace {
+	int failures = 0;
+
+	void expect(bool condition, const std::string& message) {
+		if (!condition) {
+			std::cerr << message << "\n";
+			failures++;
+		}
+	}
+
+	const std::vector<passlang::C_Check> checks = {
+		{0, 0, 0},
+		{INT_MIN, INT_MAX, -1},
+		{9, 2047, 12345}
+	};
+	const std::string checksText = "0.0.0 -2147483648.2147483647.-1 9.2047.12345";
+
+	std::string readAll(int fd) {
+		std::string data;
+		char buffer[4096];
+		ssize_t size;
+		while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+			data.append(buffer, size_t(size));
+		}
+		return data;
+	}
+
+	void testText() {
+		std::string buffer(passlang::Serializer::textSizeBound(checks.size()), '\0');
+		size_t size = passlang::Serializer::writeText(checks.data(), checks.size(), &buffer[0], buffer.size());
+		expect(buffer.substr(0, size) == checksText, "writeText: got " + buffer.substr(0, size));
+
+		// The longest check fits the bound with its separator
+		std::vector<passlang::C_Check> longest = {{INT_MIN, INT_MIN, INT_MIN}, {INT_MIN, INT_MIN, INT_MIN}};
+		buffer.assign(passlang::Serializer::textSizeBound(longest.size()), '\0');
+		size = passlang::Serializer::writeText(longest.data(), longest.size(), &buffer[0], buffer.size());
+		expect(size == 2 * 35 + 1 && passlang::Serializer::maxTextCheckSize == 36, "writeText: longest checks take " + std::to_string(size) + " bytes");
+
+		bool raised = false;
+		try {
+			passlang::Serializer::writeText(checks.data(), checks.size(), &buffer[0], passlang::Serializer::textSizeBound(checks.size()) - 1);
+		}
+		catch (const std::runtime_error&) {
+			raised = true;
+		}
+		expect(raised, "writeText: buffer smaller than the bound is accepted");
+
+		passlang::Result<size_t> result = passlang::Serializer::tryWriteText(checks.data(), checks.size(), &buffer[0], passlang::Serializer::textSizeBound(checks.size()) - 1);
+		expect(!result && result.error().code == passlang::ErrorCode::bufferTooSmall, "tryWriteText: small buffer isn't bufferTooSmall");
+	}
+
+	void testBinary() {
+		std::vector<passlang::C_Check> frame = {{1, 0x01020304, -1}};
+		std::string buffer(passlang::Serializer::binarySize(frame.size()), '\0');
+		size_t size = passlang::Serializer::writeBinary(frame.data(), frame.size(), &buffer[0], buffer.size());
+		const std::string expected("\x01\x00\x00\x00" "\x01\x00\x00\x00" "\x04\x03\x02\x01" "\xff\xff\xff\xff", 16);
+		expect(size == 16 && buffer == expected, "writeBinary: wrong little-endian layout");
+	}
+
+	// Text and binary frames written through FdWriter, read back from a pipe after the writer is destroyed
+	std::string writeThroughPipe(size_t bufferSize, size_t limit) {
+		int fds[2];
+		if (pipe(fds)) {
+			throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+		}
+		limitedFd = limit ? fds[1] : -1;
+		writeLimit = limit;
+		interrupt = limit != 0;
+		{
+			passlang::Serializer::FdWriter writer(fds[1], bufferSize);
+			writer.write(checks, passlang::Serializer::Format::text);
+			writer.write(checks.data(), 1, passlang::Serializer::Format::binary);
+			writer.writeRaw("raw", 3);
+		}
+		limitedFd = -1;
+		close(fds[1]);
+		std::string data = readAll(fds[0]);
+		close(fds[0]);
+		return data;
+	}
+
+	void testFdWriter() {
+		const std::string expected = checksText + "\n" + std::string("\x01\x00\x00\x00" "\x00\x00\x00\x00" "\x00\x00\x00\x00" "\x00\x00\x00\x00", 16) + "raw";
+
+		expect(writeThroughPipe(passlang::Serializer::FdWriter::defaultBufferSize, 0) == expected, "FdWriter: destructor doesn't flush buffered data");
+		expect(writeThroughPipe(8, 5) == expected, "FdWriter: data is lost on short or interrupted writes");
+
+		passlang::Serializer::FdWriter closed(-1, 8);
+		passlang::Result<size_t> result = closed.tryWriteRaw("written at once", 15);
+		expect(!result && result.error().code == passlang::ErrorCode::writeFailed, "FdWriter::tryWriteRaw: failed write isn't writeFailed");
+	}
+}
+
+int main() {
+	testText();
+	testBinary();
+	testFdWriter();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/passlang.h"
+#include "../src/specializer.h"
+
+
+// Original and specialized programs must give the same checks. Random ranges and choices take values
+// depending only on their bounds, so folded choices, which don't draw, can't shift the sequence
+namespace {
+	struct Case {
+		std::string expression;
+		int numberOfChecks;
+	};
+
+	const std::vector<Case> cases = {
+		{"3(0(1.1.1) i0.i0.i0)", 5},
+		{"2([1.1.1;0] i0.i0.i0)", 5},
+		{"2([1.1.1;1;2] i0.i0.i0)", 3},
+		{"2([0(1.1.1);1;1] i0.i0.i0)", 3},
+		{"2((n - 3)(1.1.1) i0.(i0*2).n)", 3},
+		{"n(1.1.1 [2.2.2;100] i0.(i0*2).n)", 4},
+		{"2(n(i0.i1.1) 0-5.(n+1).[3 4])", 3},
+		{"0(1.1.1) [1.1.1;0] (n - 1).-.-", 6},
+		{"2([1.1.1;50 2.2.2] 3(0(5.5.5) [i1.i0.0;0] i1.i0.n))", 2}
+	};
+
+	int randrange(int start, int finish) {
+		return start + (start * 7 + finish * 13) % (finish - start + 1);
+	}
+
+	passlang::C_Check construct(int world, int x, int y) {
+		return {world, x, y};
+	}
+
+	passlang::Result<std::pmr::vector<passlang::C_Check>> run(const passlang::Program& program, int numberOfChecks) {
+		passlang::Interpreter interpreter(numberOfChecks, construct, randrange);
+		interpreter.choiceCallback = [] { return randrange(1, 100); };
+		return passlang::tryEvaluate(program, interpreter);
+	}
+
+	std::string format(passlang::Result<std::pmr::vector<passlang::C_Check>>& result) {
+		if (!result) {
+			return "error: " + result.error().message;
+		}
+		std::string text;
+		for (auto& i: result.value()) {
+			text += std::to_string(i.world) + "." + std::to_string(i.x) + "." + std::to_string(i.y) + " ";
+		}
+		return text;
+	}
+}
+
+int main() {
+	int failures = 0;
+	for (auto& i: cases) {
+		// The original is destroyed before the residual runs, so the residual must not point into its nodes
+		passlang::Program residual;
+		std::string expected;
+		{
+			passlang::Result<passlang::Program> compiled = passlang::tryCompile(i.expression);
+			if (!compiled) {
+				std::cerr << i.expression << ": " << compiled.error().message << "\n";
+				failures++;
+				continue;
+			}
+			auto original = run(compiled.value(), i.numberOfChecks);
+			expected = format(original);
+			residual = passlang::specialize(compiled.value(), i.numberOfChecks);
+		}
+
+		auto actual = run(residual, i.numberOfChecks);
+		if (format(actual) != expected) {
+			std::cerr << i.expression << " (n = " << i.numberOfChecks << "): expected " << expected << ", specialized gives " << format(actual) << "\n";
+			failures++;
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/passlang.h"
+#include "../src/validator.h"
+
+
+// Validator must accept exactly what tryCompile accepts and report the same error code and offset.
+// Arithmetic runs "*" and "/" first, then "+", "-" and "%" from left to right, in both of them
+namespace {
+	int failures = 0;
+
+	const std::vector<std::string> expressions = {
+		"1.1.1",
+		"n(i0.-.-)",
+		"2(3(i0.i1.(i0 * 2 + i1)))",
+		"[1.1.1;30 2.2.2;70]",
+		"1.(2 * 3 + 4 * 5).1",
+		"1.(1 + 2 * 3 * 4 - 5).1",
+		"1.(7 % 4 - 10 / 3).1",
+		"1.1",
+		"1..1",
+		"1.1.1 2.2.",
+		"(1.1.1",
+		"1.1.1)",
+		"1.(2 +).1",
+		"[1.1.1;",
+		"[1.1.1;50;]",
+		"2(i3.1.1)",
+		"99999999999.1.1",
+		"1.(n(1.1.1)).1",
+		"1.1.1;",
+		"",
+		" "
+	};
+
+	bool isSemantic(passlang::ErrorCode code) {
+		return code == passlang::ErrorCode::none || code == passlang::ErrorCode::unknownIterator || code == passlang::ErrorCode::chanceOverflow || code == passlang::ErrorCode::invalidArithmetic;
+	}
+
+	void compare(const std::string& expression) {
+		passlang::Result<passlang::Program> compiled = passlang::tryCompile(expression);
+		passlang::Validation validation = passlang::validate(expression);
+
+		// Validator also finds semantic errors, which compile leaves to evaluation time
+		bool same = compiled ? isSemantic(validation.error.code) : validation.error.code == compiled.error().code && validation.error.offset == compiled.error().offset;
+		if (!same) {
+			std::cerr << "[" << expression << "]: compile " << (compiled ? std::string("accepts") : compiled.error().message + " at " + std::to_string(compiled.error().offset))
+				<< ", validator " << validation.error.message << " at " << validation.error.offset << "\n";
+			failures++;
+		}
+	}
+
+	void expectY(const std::string& expression, int y) {
+		passlang::Interpreter interpreter(1, [](int world, int x, int y) -> passlang::C_Check { return {world, x, y}; }, [](int start, int) { return start; });
+		passlang::Result<passlang::Program> compiled = passlang::tryCompile("1.1." + expression);
+		if (!compiled) {
+			std::cerr << expression << ": " << compiled.error().message << "\n";
+			failures++;
+			return;
+		}
+		passlang::Result<std::pmr::vector<passlang::C_Check>> checks = passlang::tryEvaluate(compiled.value(), interpreter);
+		if (!checks || checks.value().size() != 1 || checks.value()[0].y != y) {
+			std::cerr << expression << ": expected " << y << "\n";
+			failures++;
+		}
+	}
+}
+
+int main() {
+	for (auto& i: expressions) {
+		compare(i);
+	}
+
+	// Random strings over the alphabet of the grammar, fixed seed
+	std::mt19937 random(1);
+	const std::string alphabet = "0123456789.-+*/%()[];ni ";
+	for (int i = 0; i < 20000; i++) {
+		std::string expression;
+		for (size_t length = 1 + random() % 14; length; length--) {
+			expression += alphabet[random() % alphabet.size()];
+		}
+		compare(expression);
+	}
+
+	expectY("(2 * 3 + 4 * 5)", 26);
+	expectY("(1 + 2 * 3 * 4 - 5)", 20);
+	expectY("(7 % 4 - 10 / 3)", 0);
+	expectY("(20 - 2 * 3 % 4)", 2);
+	return failures ? 1 : 0;
+}